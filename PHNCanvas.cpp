@@ -0,0 +1,174 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PHNCanvas.h"
+
+/* Amount of pixels transferred from SRAM to the screen at once during blitting */
+#define CANVAS_BLIT_CHUNK 64
+
+PHN_Canvas::PHN_Canvas(uint16_t width, uint16_t height, SRAMHandle address) {
+  _width = width;
+  _height = height;
+  _address = address;
+  _blitTime = 0;
+}
+
+bool PHN_Canvas::clip(uint16_t &x, uint16_t &y, uint16_t &w, uint16_t &h) {
+  if (x >= _width || y >= _height || !w || !h) return false;
+  if (w > (_width - x)) w = (_width - x);
+  if (h > (_height - y)) h = (_height - y);
+  return true;
+}
+
+void PHN_Canvas::fill(uint8_t color) {
+  sram.fillBlock(_address, color, size());
+}
+
+void PHN_Canvas::drawPixel(uint16_t x, uint16_t y, uint8_t color) {
+  if (x < _width && y < _height) {
+    sram.write(_address + y * _width + x, color);
+  }
+}
+
+uint8_t PHN_Canvas::readPixel(uint16_t x, uint16_t y) {
+  if (x < _width && y < _height) {
+    return sram.read(_address + y * _width + x);
+  }
+  return 0;
+}
+
+void PHN_Canvas::drawHorizontalLine(uint16_t x, uint16_t y, uint16_t length, uint8_t color) {
+  fillRect(x, y, length, 1, color);
+}
+
+void PHN_Canvas::drawVerticalLine(uint16_t x, uint16_t y, uint16_t length, uint8_t color) {
+  fillRect(x, y, 1, length, color);
+}
+
+void PHN_Canvas::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+  // Straight lines are filled as rectangles, using sequential SRAM writes
+  if (x0 == x1 || y0 == y1) {
+    if (x1 < x0) swap(x0, x1);
+    if (y1 < y0) swap(y0, y1);
+    if (x1 < 0 || y1 < 0) return;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    fillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+    return;
+  }
+
+  // Bresenham's algorithm for all other lines
+  int16_t dx = abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+  int16_t dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
+  int16_t err = dx + dy, e2;
+  for (;;) {
+    if (x0 >= 0 && y0 >= 0) drawPixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) break;
+    e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+void PHN_Canvas::drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t color) {
+  drawHorizontalLine(x, y, w, color);
+  drawHorizontalLine(x, y + h - 1, w, color);
+  drawVerticalLine(x, y, h, color);
+  drawVerticalLine(x + w - 1, y, h, color);
+}
+
+void PHN_Canvas::fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t color) {
+  if (!clip(x, y, w, h)) return;
+
+  // When the full width is filled, fill all rows in one sequential write
+  uint16_t addr = _address + y * _width + x;
+  if (w == _width) {
+    sram.fillBlock(addr, color, w * h);
+  } else {
+    do {
+      sram.fillBlock(addr, color, w);
+      addr += _width;
+    } while (--h);
+  }
+}
+
+void PHN_Canvas::drawChar(uint16_t x, uint16_t y, uint8_t scale, char c, uint8_t color0, uint8_t color1) {
+  // Read character data into memory
+  uint8_t data[5];
+  memcpy_P(data, phn_font_5x7 + (c * 5), 5);
+
+  // Clear the background, then draw the set pixels of each column
+  fillRect(x, y, 5 * scale, 8 * scale, color0);
+  for (uint8_t dx = 0; dx < 5; dx++) {
+    uint8_t pix_dat = data[dx];
+    for (uint8_t dy = 0; pix_dat; dy++) {
+      if (pix_dat & 0x1) {
+        fillRect(x + dx * scale, y + dy * scale, scale, scale, color1);
+      }
+      pix_dat >>= 1;
+    }
+  }
+}
+
+void PHN_Canvas::drawString(uint16_t x, uint16_t y, uint8_t scale, const char* text, uint8_t color0, uint8_t color1) {
+  uint16_t c_x = x;
+  uint16_t c_y = y;
+  while (*text) {
+    if (*text == '\n') {
+      c_x = x;
+      c_y += 8*scale;
+    } else {
+      drawChar(c_x, c_y, scale, *text, color0, color1);
+      c_x += 6*scale;
+    }
+    text++;
+  }
+}
+
+void PHN_Canvas::blit(uint16_t x, uint16_t y) {
+  uint32_t startTime = micros();
+  uint8_t buff[CANVAS_BLIT_CHUNK];
+  uint16_t addr = _address;
+  uint16_t remaining = size();
+  uint16_t len;
+
+  // Set up a viewport so the pixels wrap around at the canvas edges
+  PHNDisplayHW::setViewport(x, y, x + _width - 1, y + _height - 1);
+  PHNDisplayHW::setCursor(x, y, DIR_RIGHT_WRAP_DOWN);
+
+  // Read the canvas in sequential SRAM bursts and write out the pixels in bulk
+  while (remaining) {
+    len = min(remaining, CANVAS_BLIT_CHUNK);
+    sram.readBlock(addr, (char*) buff, len);
+    PHNDisplay8Bit::writePixels(buff, len);
+    addr += len;
+    remaining -= len;
+  }
+
+  // Restore the viewport to the full screen
+  PHNDisplayHW::setViewport(0, 0, PHNDisplayHW::WIDTH - 1, PHNDisplayHW::HEIGHT - 1);
+
+  _blitTime = micros() - startTime;
+}
@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**@file
+ * @brief Contains the PHN_Canvas class for composing drawings off-screen in external SRAM
+ */
+
+#ifndef _PHN_CANVAS_H_
+#define _PHN_CANVAS_H_
+
+#include "PHNDisplayHardware.h"
+#include "PHNSRAM.h"
+#include <utility/PHNUtils.h>
+
+/**
+ * @brief Off-screen drawing surface stored inside the external SRAM chip
+ *
+ * Drawing many overlapping shapes directly to the screen causes visible flicker.
+ * With a canvas, shapes and text are instead drawn into the external SRAM first.
+ * Once finished, the canvas is copied to the screen in one go using blit().
+ *
+ * Pixels are stored using 8-bit colors, one byte per pixel, the same colors as used
+ * by the @link PHNDisplay8Bit 8-bit display functions @endlink. This means that
+ * a 320 x 100 pixel canvas fits inside the 32 Kilobyte SRAM chip. The coordinates used
+ * for blitting are in the hardware orientation of the screen (no rotation).
+ *
+ * Make sure sram.begin() was called before drawing to the canvas. The SRAM memory
+ * for the pixels is best allocated from an arena, so it does not overlap with the
+ * memory of other canvases or modules:
+ *
+ * @code
+ * uint8_t arena = sram.createArena("CANVAS", 320 * 100);
+ * PHN_Canvas canvas(320, 100, sram.alloc(arena, 320 * 100));
+ * @endcode
+ */
+class PHN_Canvas {
+ public:
+  /// Creates a new canvas of the dimensions specified, stored at an SRAM address
+  PHN_Canvas(uint16_t width, uint16_t height, SRAMHandle address);
+
+  /// Gets the width of the canvas
+  uint16_t width() const { return _width; }
+  /// Gets the height of the canvas
+  uint16_t height() const { return _height; }
+  /// Gets the SRAM address where the pixels of the canvas are stored
+  uint16_t address() const { return _address; }
+  /// Gets the amount of SRAM bytes occupied by the canvas
+  uint16_t size() const { return _width * _height; }
+
+  /// Fills the entire canvas with an 8-bit color
+  void fill(uint8_t color);
+  /// Draws a single pixel
+  void drawPixel(uint16_t x, uint16_t y, uint8_t color);
+  /// Reads the 8-bit color of a single pixel, 0 outside the canvas
+  uint8_t readPixel(uint16_t x, uint16_t y);
+  /// Draws a straight line to the right starting at [x, y]
+  void drawHorizontalLine(uint16_t x, uint16_t y, uint16_t length, uint8_t color);
+  /// Draws a straight line down starting at [x, y]
+  void drawVerticalLine(uint16_t x, uint16_t y, uint16_t length, uint8_t color);
+  /// Draws a line from one point to another
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
+  /// Draws a rectangle at [x, y] with dimensions [w, h]
+  void drawRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t color);
+  /// Fills a rectangle at [x, y] with dimensions [w, h]
+  void fillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t color);
+  /// Draws a Character using the standard font, color0 being the background and color1 the foreground
+  void drawChar(uint16_t x, uint16_t y, uint8_t scale, char c, uint8_t color0, uint8_t color1);
+  /// Draws a String using the standard font, color0 being the background and color1 the foreground
+  void drawString(uint16_t x, uint16_t y, uint8_t scale, const char* text, uint8_t color0, uint8_t color1);
+
+  /// Copies the full canvas to the screen with the top-left corner at [x, y]
+  void blit(uint16_t x, uint16_t y);
+  /**@brief Gets the time in microseconds it took to perform the last blit()
+   *
+   * Use this to measure the SRAM to screen throughput. The amount of pixels
+   * (bytes) transferred per second equals size() * 1000000 / getBlitTime().
+   */
+  uint32_t getBlitTime() const { return _blitTime; }
+
+ private:
+  /// Clips a rectangle to the canvas bounds, returns false if nothing is left
+  bool clip(uint16_t &x, uint16_t &y, uint16_t &w, uint16_t &h);
+
+  uint16_t _width, _height;
+  uint16_t _address;
+  uint32_t _blitTime;
+};
+
+#endif
@@ -24,6 +24,7 @@ THE SOFTWARE.
 */
 
 #include "PHNDisplay.h"
+#include "PHNSDMinimal.h"
 
 static const uint8_t DIR_TRANSFORM[] = {DIR_RIGHT_WRAP_DOWN, DIR_DOWN_WRAP_DOWN,
                                           DIR_LEFT_WRAP_DOWN, DIR_UP_WRAP_DOWN,
@@ -1000,6 +1001,14 @@ void PHN_Display::debugPrint(uint16_t x, uint16_t y, uint8_t size, float value)
   debugPrint(x, y, size, buff, 6);
 }
 
+// Amount of pixels decoded at once before writing them out to the screen
+#define IMG_CHUNK_PIXELS 32
+
+// Skips bytes of an image stream, negative counts are ignored
+static void ImgSkip(ChunkReader &imageStream, int32_t count) {
+  if (count > 0) imageStream.skip(count);
+}
+
 static float ImgMultColor_r, ImgMultColor_g, ImgMultColor_b;
 static void ImgMultColor(uint8_t *r, uint8_t *g, uint8_t *b) {
   *r = (uint8_t) min((float) (*r) * ImgMultColor_r, 255);
@@ -1007,28 +1016,87 @@ static void ImgMultColor(uint8_t *r, uint8_t *g, uint8_t *b) {
   *b = (uint8_t) min((float) (*b) * ImgMultColor_b, 255);
 }
 
-void PHN_Display::drawImage(Stream &imageStream, int x, int y) {
+void PHN_Display::drawImage(ChunkReader imageStream, int x, int y) {
   drawImageMain(imageStream, x, y, NULL, NULL);
 }
 
-void PHN_Display::drawImage(Stream &imageStream, int x, int y, float brightness) {
+void PHN_Display::drawImage(ChunkReader imageStream, int x, int y, float brightness) {
   drawImage(imageStream, x, y, brightness, brightness, brightness);
 }
 
-void PHN_Display::drawImage(Stream &imageStream, int x, int y, float cr, float cg, float cb) {
+void PHN_Display::drawImage(ChunkReader imageStream, int x, int y, float cr, float cg, float cb) {
   // Set color component factors, then draw using the ImgMultColor color transform function
   ImgMultColor_r = cr; ImgMultColor_g = cg; ImgMultColor_b = cb;
   drawImageMain(imageStream, x, y, ImgMultColor, NULL);
 }
-void PHN_Display::drawImage(Stream &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*)) {
+void PHN_Display::drawImage(ChunkReader imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*)) {
   drawImageMain(imageStream, x, y, color, NULL);
 }
 
-void PHN_Display::drawImage(Stream &imageStream, int x, int y, const color_t *colorMapInput) {
+void PHN_Display::drawImage(ChunkReader imageStream, int x, int y, const color_t *colorMapInput) {
   drawImageMain(imageStream, x, y, NULL, colorMapInput);
 }
 
-void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*), const color_t *colorMapInput) {
+/* 
+ * Stream reading the file opened using the minimal SD library, used by drawImageFile
+ * Chunks point straight into the cache of the SD library, up to the end of the block.
+ * When a new block is entered, the next block of the same cluster is requested right away.
+ * The card then prepares it while the pixels of the current block are drawn.
+ */
+class ImgFileStream : public ChunkStream {
+ public:
+  ImgFileStream() : _block(0xFFFFFFFF) {}
+  int available() { return min(file_size - file_position, 0x7fff); }
+  int read() {
+    const uint8_t* p;
+    if (!acquireChunk(&p, 1)) return -1;
+    releaseChunk(1);
+    return *p;
+  }
+  size_t acquireChunk(const uint8_t** ptr, size_t max) {
+    if (file_position >= file_size) return 0;
+    *ptr = volume_cacheCurrentBlock(0);
+    if (volume_cacheBlockNumber != _block) {
+      _block = volume_cacheBlockNumber;
+      if ((file_position | 0x1FF) < file_size && ((_block + 1 - volume.dataStartBlock) & (volume.blocksPerCluster - 1))) {
+        block_read_begin(_block + 1);
+      }
+    }
+    return min(max, min(file_size - file_position, (uint32_t) (512 - (file_position & 0x1FF))));
+  }
+  void releaseChunk(size_t count) { file_position += count; }
+  int peek() { return -1; }
+  void flush() {}
+  size_t write(uint8_t) { return 0; }
+ private:
+  uint32_t _block;
+};
+
+void PHN_Display::drawImageFile(int x, int y) {
+  // Read the format identifier and LCD header, all within the first block
+  char id[3];
+  Imageheader_LCD header;
+  memcpy(id, file_read(sizeof(id)), sizeof(id));
+  memcpy(&header, file_read(sizeof(header)), sizeof(header));
+
+  if (!memcmp(id, "LCD", 3) && header.bpp == 16 && !header.colors) {
+    // 16-bit image without colormap: stream the pixels straight to the screen
+    Viewport oldViewport = getViewport();
+    setViewportRelative(x, y, header.width, header.height);
+    setWrapMode(WRAPMODE_DOWN);
+    goTo(0, 0, 0);
+    file_read_lcd((uint32_t) header.width * (uint32_t) header.height);
+    setViewport(oldViewport);
+  } else {
+    // Go back to the start of the file and draw it as any other image stream
+    file_position = 0;
+    ImgFileStream stream;
+    ChunkReader reader(stream);
+    drawImageMain(reader, x, y, NULL, NULL);
+  }
+}
+
+void PHN_Display::drawImageMain(ChunkReader &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*), const color_t *colorMapInput) {
   // Store old viewport for later restoring
   Viewport oldViewport = getViewport();
 
@@ -1038,15 +1106,39 @@ void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)
       // Bitmap
       // read the BITMAP file header
       Imageheader_BMP header;
-      imageStream.readBytes((char*) &header, sizeof(header));
-      if (!header.biClrUsed) header.biClrUsed = (1 << header.bitCount);
-  
+      imageStream.read(&header, sizeof(header));
+      uint32_t pos = sizeof(header) + 2;
+
+      // Only formats up to 8 bits per pixel make use of a color table
+      uint8_t bpp = header.bitCount;
+      if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 24) return;
+      uint16_t colorCount = 0;
+      if (bpp <= 8) {
+        colorCount = header.biClrUsed ? header.biClrUsed : (1 << bpp);
+      }
+
+      // 16-bit bitmaps are 555 unless BI_BITFIELDS specifies the 565 color masks
+      uint8_t is565 = 0;
+      if (bpp == 16 && header.compression == 3) {
+        uint32_t masks[3];
+        imageStream.read(masks, sizeof(masks));
+        pos += sizeof(masks);
+        is565 = (masks[0] == 0xF800 && masks[1] == 0x07E0 && masks[2] == 0x001F);
+      }
+
+      // The color table follows after the full info header, and after the masks when
+      // these are stored following a 40-byte header. Never move the position backwards.
+      if (pos < 14 + header.headerSize) {
+        ImgSkip(imageStream, (int32_t) (14 + header.headerSize - pos));
+        pos = 14 + header.headerSize;
+      }
+
       // Read the pixel map
-      color_t colorMap[header.biClrUsed];
+      color_t colorMap[colorCount ? colorCount : 1];
       Color_ARGB argb;
       uint16_t ci;
-      for (ci = 0; ci < header.biClrUsed; ci++) {
-        imageStream.readBytes((char*) &argb, sizeof(argb));
+      for (ci = 0; ci < colorCount; ci++) {
+        imageStream.read(&argb, sizeof(argb));
         if (colorMapInput) {
           colorMap[ci] = colorMapInput[ci];
         } else {
@@ -1056,45 +1148,94 @@ void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)
           colorMap[ci] = PHNDisplayHW::color565(argb.r, argb.g, argb.b);
         }
       }
+      pos += (uint32_t) colorCount * 4;
 
       // Skip ahead towards the pixel map (this is usually never needed)
-      uint32_t pos = sizeof(header) + 2 + (header.biClrUsed * 4);
-      for (; pos < header.pixelDataOffset; pos++) {
-        imageStream.read();
-      }
+      ImgSkip(imageStream, (int32_t) (header.pixelDataOffset - pos));
+
+      // A negative height indicates the rows are stored top-down
+      uint8_t topDown = ((int32_t) header.height < 0);
+      uint16_t height = topDown ? -((int32_t) header.height) : header.height;
+      uint16_t width = header.width;
 
       // Set up the viewport to render the bitmap in
-      setViewportRelative(x, y, header.width, header.height);
+      setViewportRelative(x, y, width, height);
+      if (topDown) {
+        // Go to the top-left pixel, drawing DOWNWARDS
+        setWrapMode(WRAPMODE_DOWN);
+        goTo(0, 0, 0);
+      } else {
+        // Go to the bottom-left pixel, drawing UPWARDS (!)
+        setWrapMode(WRAPMODE_UP);
+        goTo(0, height - 1, 0);
+      }
 
-      // Go to the bottom-left pixel, drawing UPWARDS (!)
-      setWrapMode(WRAPMODE_UP);
-      goTo(0, header.height - 1, 0);
-
-      // Used variables and calculated constants
-      uint16_t px, py;
-      uint16_t imageWidthSize = ((uint32_t) header.bitCount * header.width) >> 3;
-      uint8_t imageWidthPadding = (4 - (imageWidthSize & 0x3)) & 0x3;
-
-      // Process each row of pixels
-      for (py = 0; py < header.height; py++) {
-        // Draw visible Bitmap portion
-        if (header.bitCount == 8) {
-          for (px = 0; px < header.width; px++) {
-            PHNDisplay16Bit::writePixel(colorMap[imageStream.read() & 0xFF]);
-          }
-        } else if (header.bitCount == 24) {
-          // Color transform used?
-          for (px = 0; px < header.width; px++) {
-            imageStream.readBytes((char*) &argb, 3);
-            if (color) color(&argb.r, &argb.g, &argb.b);
-            PHNDisplay16Bit::writePixel(PHNDisplayHW::color565(argb.r, argb.g, argb.b));
+      // Rows are padded to a multiple of 4 bytes
+      uint16_t rowSize = ((uint32_t) bpp * width + 7) >> 3;
+      uint8_t rowPadding = (4 - (rowSize & 0x3)) & 0x3;
+
+      // Pixels are decoded into a scanline buffer in chunks, then written out in bulk
+      // Chunks of streams supporting it are decoded in place, without copying them first
+      color_t line[IMG_CHUNK_PIXELS];
+      uint8_t raw[IMG_CHUNK_PIXELS * 3];
+      const uint8_t* p;
+      uint16_t px, py, n, i;
+      for (py = 0; py < height; py++) {
+        for (px = 0; px < width; px += n) {
+          n = min(width - px, IMG_CHUNK_PIXELS);
+
+          if (bpp == 16) {
+            // 565 data needs no conversion and is written out straight from the chunk
+            n = imageStream.readChunk(&p, n << 1, (uint8_t*) line, 2) >> 1;
+            if (!n) break;
+            if (is565 && !color) {
+              PHNDisplay16Bit::writePixels((color_t*) p, n);
+              continue;
+            }
+            for (i = 0; i < n; i++) {
+              color_t c = p[i << 1] | (p[(i << 1) + 1] << 8);
+              if (!is565) {
+                c = ((c & 0x7FE0) << 1) | (c & 0x001F);
+              }
+              if (color) {
+                uint8_t r = (c >> 8) & 0xF8, g = (c >> 3) & 0xFC, b = (c << 3);
+                color(&r, &g, &b);
+                c = PHNDisplayHW::color565(r, g, b);
+              }
+              line[i] = c;
+            }
+          } else if (bpp == 24) {
+            n = imageStream.readChunk(&p, n * 3, raw, 3) / 3;
+            if (!n) break;
+            for (i = 0; i < n; i++) {
+              uint8_t r = p[2], g = p[1], b = p[0];
+              if (color) color(&r, &g, &b);
+              line[i] = PHNDisplayHW::color565(r, g, b);
+              p += 3;
+            }
+          } else {
+            // Indexed pixels, most significant bits are the left-most pixel
+            // A chunk ending before the last pixel requested holds whole bytes of pixels
+            uint16_t count = imageStream.readChunk(&p, ((uint16_t) n * bpp + 7) >> 3, raw);
+            if (!count) break;
+            n = min(n, (count << 3) / bpp);
+            uint8_t pixelmask = (1 << bpp) - 1;
+            uint8_t data = 0;
+            uint8_t shift = 0;
+            for (i = 0; i < n; i++) {
+              if (!shift) {
+                data = *(p++);
+                shift = 8;
+              }
+              shift -= bpp;
+              line[i] = colorMap[(data >> shift) & pixelmask];
+            }
           }
+          PHNDisplay16Bit::writePixels(line, n);
         }
 
         // Handle padding
-        for (px = 0; px < imageWidthPadding; px++) {
-          imageStream.read();
-        }
+        ImgSkip(imageStream, rowPadding);
       }
     }
   } else if (idChar == 'L') { 
@@ -1102,7 +1243,7 @@ void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)
       // LCD format
       // Read LCD headers
       Imageheader_LCD header;
-      imageStream.readBytes((char*) &header, sizeof(header));
+      imageStream.read(&header, sizeof(header));
       uint32_t imagePixels = (uint32_t) header.width * (uint32_t) header.height;
 
       // Read colormap, empty if not used/available
@@ -1111,7 +1252,7 @@ void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)
       color_t c565;
       uint8_t r, g, b;
       for (ci = 0; ci < header.colors; ci++) {
-        imageStream.readBytes((char*) &c565, sizeof(c565));
+        imageStream.read(&c565, sizeof(c565));
         if (colorMapInput) {
           colorMap[ci] = colorMapInput[ci];
         } else if (color) {
@@ -1134,18 +1275,27 @@ void PHN_Display::drawImageMain(Stream &imageStream, int x, int y, void (*color)
 
       // Write pixels to screen
       if (header.bpp == 16) {
-        // Fast method
-        uint32_t i;
-        for (i = 0; i < imagePixels; i++) {
-          imageStream.readBytes((char*) &c565, sizeof(c565));
-          if (color) {
+        // Fast method, pixels are written out a chunk at a time
+        color_t line[IMG_CHUNK_PIXELS];
+        const uint8_t* p;
+        uint16_t n, i;
+        while (imagePixels) {
+          n = imageStream.readChunk(&p, min(imagePixels, IMG_CHUNK_PIXELS) << 1, (uint8_t*) line, 2) >> 1;
+          if (!n) break;
+          imagePixels -= n;
+          if (!color) {
+            PHNDisplay16Bit::writePixels((color_t*) p, n);
+            continue;
+          }
+          for (i = 0; i < n; i++) {
+            c565 = p[i << 1] | (p[(i << 1) + 1] << 8);
             r = PHNDisplayHW::color565Red(c565);
             g = PHNDisplayHW::color565Green(c565);
             b = PHNDisplayHW::color565Blue(c565);
             color(&r, &g, &b);
-            c565 = PHNDisplayHW::color565(r, g, b);
+            line[i] = PHNDisplayHW::color565(r, g, b);
           }
-          PHNDisplay16Bit::writePixel(c565);
+          PHNDisplay16Bit::writePixels(line, n);
         }
       } else {
         int tmpbuff = 0;
@@ -431,6 +431,8 @@ class PHN_Display : public PHN_WidgetContainer {
    * Send in a stream of data containing the .BMP or .LCD image contents.
    * For this you can make use of the SD File, FlashMemoryStream and MemoryStream.
    * This way images can be stored on a variety of media, even Serial!
+   * Streams that are a ChunkStream, such as MemoryStream, FlashMemoryStream and
+   * SRAMStream, are read a chunk at a time instead of one byte at a time.
    *
    * You can draw the image with a r/g/b/brightness modifier, you can use a list
    * of colors (colormap) or you can write your own color-converting function to use.
@@ -441,18 +443,28 @@ class PHN_Display : public PHN_WidgetContainer {
    * into 1-bit (2 colors), 2-bit (4 colors), 4-bit (16 colors) or 8-bit (256 colors)
    * before use.
    *
-   * The .BMP format only supports 8-bit and 24-bit color formats. It is recommended
-   * to convert your images into .LCD using the Phoenard toolkit before use.
+   * The .BMP format supports 1-bit, 4-bit, 8-bit, 16-bit and 24-bit color formats.
+   * 16-bit bitmaps stored with 565 color masks (BI_BITFIELDS) are drawn without any
+   * color conversion. It is recommended to convert your images into .LCD using the
+   * Phoenard toolkit before use.
    */
   //@{
-  void drawImage(Stream &imageStream, int x, int y);
-  void drawImage(Stream &imageStream, int x, int y, float brightness);
-  void drawImage(Stream &imageStream, int x, int y, float cr, float cg, float cb);
-  void drawImage(Stream &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*));
-  void drawImage(Stream &imageStream, int x, int y, const color_t *colorMapInput);
+  void drawImage(ChunkReader imageStream, int x, int y);
+  void drawImage(ChunkReader imageStream, int x, int y, float brightness);
+  void drawImage(ChunkReader imageStream, int x, int y, float cr, float cg, float cb);
+  void drawImage(ChunkReader imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*));
+  void drawImage(ChunkReader imageStream, int x, int y, const color_t *colorMapInput);
   //@}
+  /**
+   * @brief Draws the image stored in the file currently opened using the minimal SD library
+   *
+   * 16-bit .LCD images are transferred from the Micro-SD straight to the screen,
+   * at close to the rate the card can be read. Other images are drawn the same
+   * way as drawImage does. The file must be opened at position 0.
+   */
+  void drawImageFile(int x, int y);
  private:
-  void drawImageMain(Stream &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*), const color_t *colorMapInput);
+  void drawImageMain(ChunkReader &imageStream, int x, int y, void (*color)(uint8_t*, uint8_t*, uint8_t*), const color_t *colorMapInput);
   void drawCircleHelper(uint16_t x0, uint16_t y0, uint16_t r, uint8_t corner, color_t color);
   void fillCircleHelper(uint16_t x0, uint16_t y0, uint16_t r, uint8_t corner, uint16_t delta, color_t color);
 
@@ -470,6 +470,24 @@ namespace PHNDisplay8Bit {
     }
   }
 
+  void writePixels(const uint8_t* colorData, uint16_t length) {
+    const uint8_t* p = colorData;
+    const uint8_t* p_end = p + length;
+    if (!length) return;
+    do {
+#if LCD_OUTPUT_SERIAL
+      PHNDisplaySerial::writeData(COLOR8TO16(*p));
+#endif
+      /* Set the port once, then spam the write instruction 2x */
+      TFTLCD_WR_PORT = WR_WRITE_A;
+      TFTLCD_DATA_PORT = *p;
+      TFTLCD_WR_PORT = WR_WRITE_B;
+      TFTLCD_WR_PORT = WR_WRITE_A;
+      asm volatile ("nop\n");
+      TFTLCD_WR_PORT = WR_WRITE_B;
+    } while (++p != p_end);
+  }
+
   void writePixelLines(uint8_t color, uint8_t lines) {
     writePixels(color, (uint32_t) lines * PHNDisplayHW::WIDTH);
   }
@@ -583,6 +601,71 @@ namespace PHNDisplay16Bit {
     return data;
   }
 
+  void readPixelsBegin(uint16_t x, uint16_t y, uint8_t direction) {
+    /* Make sure the BGR/RGB reading mode is known before reading in bulk */
+    if (!PHNDisplayHW::pixel_reading_mode) {
+      readPixel(x, y);
+    }
+
+    /*
+     * Set the cursor and perform the dummy read needed for CGRAM
+     * After this, every read returns a pixel and moves the cursor
+     */
+    PHNDisplayHW::setCursor(x, y, direction);
+    PHNDisplayHW::readData();
+  }
+
+  void readPixels(uint16_t* colorData, uint16_t length) {
+    uint16_t* p = colorData;
+    uint16_t* p_end = p + length;
+    uint16_t data;
+
+    if (!length) return;
+
+    /* Set to READ mode with pullup once for all pixels */
+    TFTLCD_DATA_DDR = 0x00;
+    TFTLCD_DATA_PORT = 0xFF;
+    do {
+      /* Read the first byte, use NOPs to give the screen time to respond */
+      TFTLCD_RD_PORT = WR_READ_A;
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      data = TFTLCD_DATA_IN << 8;
+      TFTLCD_RD_PORT = WR_READ_B;
+      /* Read the second byte */
+      TFTLCD_RD_PORT = WR_READ_A;
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      asm volatile ("nop\n");
+      data |= TFTLCD_DATA_IN;
+      TFTLCD_RD_PORT = WR_READ_B;
+
+      /* Convert BGR into RGB if needed */
+      if (PHNDisplayHW::pixel_reading_mode & 0x2) {
+        data = ((data >> 11) | (data & 0x7E0) | (data << 11));
+      }
+      *p = data;
+    } while (++p != p_end);
+
+    /* Revert back to WRITE mode, finished reading */
+    TFTLCD_DATA_DDR = 0xFF;
+  }
+
+  void readPixels(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t* colorData) {
+    /* Select the region so the cursor wraps around at the region edge */
+    PHNDisplayHW::setViewport(x, y, x + width - 1, y + height - 1);
+
+    /* Read all pixels in one go, requiring only a single dummy read */
+    readPixelsBegin(x, y, DIR_RIGHT_WRAP_DOWN);
+    readPixels(colorData, width * height);
+
+    /* Restore the viewport to the full screen */
+    PHNDisplayHW::setViewport(0, 0, PHNDisplayHW::WIDTH - 1, PHNDisplayHW::HEIGHT - 1);
+  }
+
   void writePixels(uint16_t color, uint32_t length) {
     uint8_t data_a = (color >> 8);
     uint8_t data_b = (color & 0xFF);
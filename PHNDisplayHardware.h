@@ -272,6 +272,8 @@ namespace PHNDisplay8Bit {
   void writePixel(uint8_t color);
   /// Writes out many 8-bit color pixels in bulk, length is the amount of pixels to write out
   void writePixels(uint8_t color, uint32_t length);
+  /// Writes out many 8-bit color pixels in bulk, using an array of pixel data
+  void writePixels(const uint8_t* colorData, uint16_t length);
   /// Writes out many 8-bit color pixels in bulk, specifying how many lines to fill
   void writePixelLines(uint8_t color, uint8_t lines);
   /// Drawing a line with 8-bit color
@@ -305,6 +307,12 @@ namespace PHNDisplay16Bit {
   void writePixel(uint16_t color);
   /// Reads a single 16-bit color pixel at [x, y]
   uint16_t readPixel(uint16_t x, uint16_t y);
+  /// Moves the cursor to [x, y] and prepares for reading pixels in bulk using readPixels()
+  void readPixelsBegin(uint16_t x, uint16_t y, uint8_t direction);
+  /// Reads many 16-bit color pixels in bulk from the cursor onwards, call readPixelsBegin() first
+  void readPixels(uint16_t* colorData, uint16_t length);
+  /// Reads a rectangular region of 16-bit color pixels in bulk, stored row by row
+  void readPixels(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t* colorData);
   /// Writes out many 16-bit color pixels in bulk, length is the amount of pixels to write out
   void writePixels(uint16_t color, uint32_t length);
   /// Writes out many 16-bit color pixels in bulk, using an array of pixel data
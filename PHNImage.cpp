@@ -58,11 +58,11 @@ void text_image_draw_func(int x, int y, int width, int height, PHN_Image &img) {
 }
 
 void flash_image_draw_func(int x, int y, int width, int height, PHN_Image &img) {
-  FlashMemoryStream stream(img.data_ptr(), 0xFFFFFFFF);
+  FlashMemoryStream stream = FlashMemoryStream::far(img.data_int());
   display.drawImage(stream, x, y);
 }
 
 void flash_indexed_image_draw_func(int x, int y, int width, int height, PHN_Image &img) {
-  FlashMemoryStream stream(img.data_ptr(), 0xFFFFFFFF);
+  FlashMemoryStream stream = FlashMemoryStream::far(img.data_int());
   display.drawImage(stream, x, y, img.palette().data());
 }
\ No newline at end of file
@@ -97,7 +97,7 @@ void flash_indexed_image_draw_func(int x, int y, int width, int height, PHN_Imag
 
 /// Macro for creating an image drawing text with a color border
 #define TEXT_Image(text)  PHN_Image(text_image_draw_func, text)
-/// Macro for creating an image drawing image data stored in flash
+/// Macro for creating an image drawing image data stored in flash, data can also be a far address
 #define FLASH_Image(data)  PHN_Image(flash_image_draw_func, (uint32_t) (data))
 /// Macro for creating an image drawing image data stored in flash, utilizing a color map
 #define FLASH_MAPPED_Image(data)  PHN_Image(flash_indexed_image_draw_func, (uint32_t) (data))
@@ -0,0 +1,176 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PHNSDIndex.h"
+
+/*
+ * Every slot stores the block and index of a directory entry. The upper 4 bits of the
+ * index store a hash tag, so most slots of other names are skipped without reading
+ * their directory block. Empty slots have block 0.
+ */
+static uint16_t dir_index_address;     /* SRAM address of the first slot */
+static uint16_t dir_index_mask = 0;    /* Slot count - 1, 0 if no index is built */
+static uint16_t dir_index_version;     /* Directory version the index matches */
+
+/* Computes the hash of an 8.3 format file name */
+static uint16_t dir_index_hash(const unsigned char* name) {
+  uint16_t h = 0;
+  uint8_t i = 11;
+  do {
+    h = (h << 5) - h + *(name++);
+  } while (--i);
+  return h ^ (h >> 7);
+}
+
+/* Reads or writes the slot at the index specified */
+static void dir_index_readSlot(uint16_t slot, FilePtr* ptr) {
+  sram.readBlock(dir_index_address + slot * sizeof(FilePtr), (char*) ptr, sizeof(FilePtr));
+}
+
+static void dir_index_writeSlot(uint16_t slot, const FilePtr* ptr) {
+  sram.writeBlock(dir_index_address + slot * sizeof(FilePtr), (const char*) ptr, sizeof(FilePtr));
+}
+
+/*
+ * Adds a directory entry to the index, taking the first free slot after the hash slot
+ * The SD card must be disabled when calling this function
+ */
+static uint8_t dir_index_add(const unsigned char* name, uint32_t block, uint8_t index) {
+  uint16_t h = dir_index_hash(name);
+  uint16_t slot = h & dir_index_mask;
+  FilePtr ptr;
+  do {
+    dir_index_readSlot(slot, &ptr);
+    if (!ptr.block) {
+      ptr.block = block;
+      ptr.index = index | ((h >> 12) << 4);
+      dir_index_writeSlot(slot, &ptr);
+      return 1;
+    }
+    slot = (slot + 1) & dir_index_mask;
+  } while (slot != (h & dir_index_mask));
+
+  /* Index is full */
+  return 0;
+}
+
+uint8_t dir_index_build(uint16_t address, uint16_t slotCount) {
+  DirIterator it;
+  DirEntryInfo info;
+
+  dir_index_mask = 0;
+  if (!slotCount || slotCount > DIR_INDEX_MAX_SLOTS || (slotCount & (slotCount - 1))) return 0;
+  if (!volume_init(1)) return 0;
+
+  /* Clear all slots */
+  card_setEnabled(0);
+  dir_index_address = address;
+  dir_index_mask = slotCount - 1;
+  sram.fillBlock(address, 0, slotCount * sizeof(FilePtr));
+
+  /*
+   * Go by all entries of the root directory. The iterator stops at the first free
+   * entry or at the end of the cluster chain, whichever comes first.
+   */
+  dir_iterator_begin(&it, 0, NULL);
+  for (;;) {
+    card_setEnabled(1);
+    if (!dir_iterator_next(&it, &info)) break;
+    if (info.attributes & SDMINFAT::DIR_ATT_NOT_FILE_MASK) continue;
+
+    card_setEnabled(0);
+    if (!dir_index_add((const unsigned char*) info.name, info.entry.block, info.entry.index)) goto fail;
+  }
+
+  /* Reached the end of the directory without read errors? Success! */
+  if (volume.isInitialized) {
+    dir_index_version = volume_dirVersion;
+    return 1;
+  }
+
+fail:
+  card_setEnabled(1);
+  dir_index_mask = 0;
+  return 0;
+}
+
+uint8_t dir_index_isValid(void) {
+  return dir_index_mask && volume.isInitialized && (dir_index_version == volume_dirVersion);
+}
+
+uint8_t file_open_indexed(const char* filename, const char* ext, uint8_t mode) {
+  unsigned char name[11];
+  uint16_t h, slot;
+  uint16_t version;
+  FilePtr ptr;
+  SDMINFAT::dir_t* p;
+
+  memcpy(name, filename, 8);
+  memcpy(name + 8, ext, 3);
+
+  if (dir_index_isValid()) {
+    h = dir_index_hash(name);
+    slot = h & dir_index_mask;
+    for (;;) {
+      card_setEnabled(0);
+      dir_index_readSlot(slot, &ptr);
+      card_setEnabled(1);
+
+      /* Empty slot: the file does not exist */
+      if (!ptr.block) break;
+
+      /* Only read the directory entry when the hash tag matches */
+      if ((ptr.index >> 4) == (h >> 12)) {
+        volume_readCache(ptr.block);
+        p = volume_cacheBuffer.dir + (ptr.index & 0xF);
+        if (!memcmp(name, p->name, 11)) {
+          file_curDir.block = ptr.block;
+          file_curDir.index = ptr.index & 0xF;
+          return file_open_entry(mode);
+        }
+      }
+      slot = (slot + 1) & dir_index_mask;
+
+      /* Went all the way around the index, file does not exist */
+      if (slot == (h & dir_index_mask)) break;
+    }
+
+    /* Not found, only continue when a new file is to be created */
+    if (!(mode & SDMIN_FILE_CREATE)) return 0;
+
+    /* Add the new file to the index, as long as nothing else changed the directory */
+    version = volume_dirVersion;
+    if (!file_open(filename, ext, mode)) return 0;
+    if (volume_dirVersion == (uint16_t) (version + 1)) {
+      card_setEnabled(0);
+      if (dir_index_add(name, file_curDir.block, file_curDir.index)) {
+        dir_index_version = volume_dirVersion;
+      }
+      card_setEnabled(1);
+    }
+    return 1;
+  }
+  return file_open(filename, ext, mode);
+}
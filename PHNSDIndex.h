@@ -0,0 +1,73 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief Contains a root directory index for opening files without scanning the directory
+ *
+ * Opening a file using the minimal SD library scans the root directory one entry at a time,
+ * which becomes slow when the directory holds thousands of files. The index is a hash table
+ * stored in the external SRAM, mapping every file name to the location of its directory entry.
+ * It is built in a single pass over the directory, after which opening a file costs a single
+ * block read.
+ *
+ * Files created using file_open_indexed() are added to the index. When entries are renamed,
+ * deleted or created otherwise, or the volume is initialized again, the index is invalidated
+ * and file_open_indexed() falls back to scanning the directory until the index is rebuilt.
+ *
+ * The SRAM must be initialized using sram.begin() before building the index.
+ */
+
+#ifndef _PHN_SD_INDEX_H_
+#define _PHN_SD_INDEX_H_
+
+#include "PHNSDMinimal.h"
+#include "PHNSRAM.h"
+
+/// Maximum amount of slots in the index, each slot takes up 5 bytes of SRAM
+#define DIR_INDEX_MAX_SLOTS  4096
+
+/**
+ * @brief Builds the index of all files in the root directory
+ *
+ * The index is stored in SRAM starting at the address specified and takes up
+ * slotCount * 5 bytes. The slot count must be a power of two no larger than
+ * DIR_INDEX_MAX_SLOTS, and should be well above the amount of files in the
+ * directory to keep lookups fast. Returns whether the index was built successfully.
+ */
+uint8_t dir_index_build(uint16_t address, uint16_t slotCount);
+
+/// Gets whether the index is built and still up to date with the root directory
+uint8_t dir_index_isValid(void);
+
+/**
+ * @brief Opens a file, looking up its directory entry using the index
+ *
+ * Arguments are the same as for file_open(). If the index is not valid,
+ * file_open() is used instead.
+ */
+uint8_t file_open_indexed(const char* filename, const char* ext, uint8_t mode);
+
+#endif
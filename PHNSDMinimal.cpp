@@ -24,20 +24,73 @@ THE SOFTWARE.
 */
 
 #include "PHNSDMinimal.h"
+#if VOLUME_L2_BLOCKS
+#include "PHNSRAM.h"
+#endif
 
 uint8_t card_notSDHCBlockShift;         /* Card is SD1 or SD2, and NOT SDHC. In that case this value is 9, 0 otherwise */
+uint8_t card_streamEnabled = 0;         /* Sequential data blocks are transferred using multi-block commands */
+uint8_t card_streamMode = CARD_STREAM_NONE; /* Multi-block transfer currently in progress, CARD_STREAM_NONE if none */
+uint32_t card_streamBlock;              /* Next block number of the multi-block transfer in progress */
+uint8_t card_speed = 6;                 /* SPI speed number negotiated with the card, 0 is full speed, 6 is slowest speed */
+CardStats card_stats;                   /* transfer statistics since the last card_resetStats() */
 
 union SDMINFAT::cache_t volume_cacheBuffer;      /* 512 byte cache for device blocks */
 uint32_t volume_cacheBlockNumber;       /* Logical number of block in the cache */
 uint8_t  volume_cacheDirty = 0;         /* readCache() will write current block first if true */
 uint8_t  volume_cacheFATMirror = 0;     /* current block in cache is a mirrored FAT block */
 CardVolume volume;                      /* stores all current volume information */
+uint16_t volume_dirVersion = 0;         /* Incremented every time entries are added, renamed or removed */
 
 uint8_t   file_isroot16dir;             /* file is a FAT16 root directory */
 uint32_t  file_curCluster;              /* cluster for current file position */
 uint32_t  file_position;                /* current file position in bytes from beginning */
 FilePtr   file_curDir;                  /* directory currently selected */
 uint32_t  file_size;                    /* total size of the currently opened file */
+uint32_t  file_allocStart;              /* first cluster reserved using file_preallocate() */
+uint32_t  file_allocLast = 0;           /* last cluster reserved using file_preallocate(), 0 if none */
+static uint32_t file_allocPrev;         /* last cluster of the file before the reserved clusters, 0 if none */
+static uint32_t file_allocIndex;        /* index of the first reserved cluster in the file */
+FileExtent file_extents[FILE_EXTENT_COUNT]; /* cluster runs of the file from the start, collected while walking */
+uint8_t   file_extentCount = 0;         /* amount of cluster runs stored in file_extents */
+
+/* Subdirectories resolved before, to open files in them without scanning the parent directories again */
+typedef struct {
+  uint32_t parent;             /* first cluster of the parent directory, 0 for the root directory */
+  uint32_t cluster;            /* first cluster of the directory, 0 if this entry is unused */
+  unsigned char name[11];      /* 8.3 format name of the directory */
+} DirCacheEntry;
+static DirCacheEntry dir_cache[DIR_CACHE_COUNT];
+static uint8_t dir_cacheNext = 0;
+
+/* Fastest speed to negotiate, lowered when errors occur at the speed negotiated before */
+static uint8_t card_speedLimit = SCK_SPEED;
+static uint16_t card_speedErrors = 0;
+
+/* State of a block read started using block_read_begin() */
+#define BLOCK_READ_NONE   0  /* no read requested */
+#define BLOCK_READ_BUSY   1  /* command sent, card is preparing the data */
+#define BLOCK_READ_READY  2  /* data start token received, data can be read */
+static uint8_t block_readState = BLOCK_READ_NONE;
+static uint32_t block_readNumber;
+static uint32_t card_readStart;  /* time the last read command was sent */
+
+#if VOLUME_L2_BLOCKS
+/* Second-level cache of FAT and directory blocks in external SRAM */
+static uint16_t volume_l2Address = SRAM_NULL;       /* SRAM address of the first block, SRAM_NULL if disabled */
+static uint32_t volume_l2Blocks[VOLUME_L2_BLOCKS];  /* block stored at each position, 0xFFFFFFFF if none */
+static uint8_t volume_l2LastUse[VOLUME_L2_BLOCKS];  /* use counter value when last used, to find the least recently used */
+static uint8_t volume_l2Use = 0;
+static uint8_t volume_l2Dir = 0;                    /* blocks read are directory blocks */
+#define VOLUME_L2_DIR(enabled)  volume_l2Dir = (enabled)
+#else
+#define VOLUME_L2_DIR(enabled)
+#endif
+
+/* Atomic update mode: the mirror FAT is only updated after the directory entry is written */
+static uint8_t volume_atomic = 0;
+static uint32_t volume_mirrorFirst;     /* first FAT block changed since the last commit */
+static uint32_t volume_mirrorLast = 0;  /* last FAT block changed since the last commit, 0 if none */
 /* ============================================================================== */
 
 /* Macro to send a byte to SPI */
@@ -66,6 +119,9 @@ uint8_t card_command(uint8_t cmd, uint32_t arg, uint8_t crc) {
   uint8_t* command_data_end;
   uint8_t* command_data;
 
+  /* A new command can not be sent while a multi-block transfer is in progress */
+  card_streamStop();
+
   /* Wait until no longer busy */
   /* Replaced by adding 4 flush bytes in the command struct */
   /* card_waitForData(0xFF); */
@@ -103,8 +159,59 @@ uint8_t card_waitForData(uint8_t data_state) {
   return 0;
 }
 
+/* Ends a multi-block read or write transfer, leaving the card ready for the next command */
+void card_streamStop(void) {
+  uint8_t mode = block_readState;
+  uint16_t i;
+
+  /* A block read that was requested but never finished is received and discarded */
+  block_readState = BLOCK_READ_NONE;
+  if (mode != BLOCK_READ_NONE) {
+    if (mode == BLOCK_READ_BUSY && !card_waitForData(SDMINFAT::DATA_START_BLOCK)) goto fail;
+    for (i = 0; i < 513; i++) spiRec();
+    if (card_streamMode == CARD_STREAM_READ) {
+      spiRec();
+      card_streamBlock = block_readNumber + 1;
+    }
+  }
+
+  mode = card_streamMode;
+  card_streamMode = CARD_STREAM_NONE;
+  if (mode == CARD_STREAM_READ) {
+    /* Stop the transmission, the card is busy until fully stopped */
+    card_command(SDMINFAT::CMD12, 0, 0XFF);
+    card_waitForData(SDMINFAT::DATA_IDLE_BLOCK);
+  } else if (mode == CARD_STREAM_WRITE) {
+    /* Send the stop token, skip one byte and wait until programming completes */
+    spiSend(SDMINFAT::STOP_TRAN_TOKEN);
+    spiRec();
+    if (!card_waitForData(SDMINFAT::DATA_IDLE_BLOCK)) goto fail;
+    if (card_command(SDMINFAT::CMD13, 0, 0XFF)) goto fail;
+    if (spiRec()) goto fail;
+  }
+  return;
+
+fail:
+  card_stats.errors++;
+  card_streamMode = CARD_STREAM_NONE;
+  volume.isInitialized = 0;
+}
+
+void card_resetStats(void) {
+  memset(&card_stats, 0, sizeof(card_stats));
+  card_speedErrors = 0;
+}
+
+void volume_setStreaming(uint8_t enabled) {
+  card_streamEnabled = enabled;
+  if (!enabled) card_streamStop();
+}
+
 /* Turns chip-select on/off, needed when communicating with other SPI devices */
 void card_setEnabled(uint8_t enabled) {
+  /* Other devices can not use the bus while a transfer is in progress */
+  if (!enabled) card_streamStop();
+
   /* Don't do anything if already enabled */
   if (!(SD_CS_PORT & SD_CS_MASK) && enabled) {
     return;
@@ -120,10 +227,224 @@ void card_setEnabled(uint8_t enabled) {
   }
 }
 
+#if VOLUME_L2_BLOCKS
+uint8_t volume_enableL2(void) {
+  uint8_t arena = sram.createArena("SDL2", VOLUME_L2_BLOCKS * 512);
+  if (arena == SRAM_ARENA_NONE) return 0;
+  sram.resetArena(arena);
+  volume_l2Address = sram.alloc(arena, VOLUME_L2_BLOCKS * 512);
+  memset(volume_l2Blocks, 0xFF, sizeof(volume_l2Blocks));
+  return 1;
+}
+
+void volume_disableL2(void) {
+  volume_l2Address = SRAM_NULL;
+}
+
+/* Finds the position of a block in the second-level cache, VOLUME_L2_BLOCKS if not stored */
+static uint8_t volume_l2Find(uint32_t block) {
+  uint8_t i;
+  for (i = 0; i < VOLUME_L2_BLOCKS && volume_l2Blocks[i] != block; i++);
+  return i;
+}
+
+/* Transfers a block between the second-level cache and RAM, the card gives up the bus meanwhile */
+static void volume_l2Transfer(uint8_t i, uint8_t* data, uint8_t write) {
+  uint16_t address = volume_l2Address + (i << 9);
+  volume_l2LastUse[i] = ++volume_l2Use;
+  card_setEnabled(0);
+  if (write) {
+    sram.writeBlock(address, (const char*) data, 512);
+  } else {
+    sram.readBlock(address, (char*) data, 512);
+  }
+  card_setEnabled(1);
+}
+
+/*
+ * Reads a FAT or directory block from the second-level cache
+ * Returns 0 if the block must be read from the card instead
+ */
+static uint8_t volume_l2Read(uint32_t block, uint8_t* data) {
+  if (volume_l2Address == SRAM_NULL || !volume.isInitialized) return 0;
+  if (block >= volume.dataStartBlock && !volume_l2Dir) return 0;
+
+  uint8_t i = volume_l2Find(block);
+  if (i == VOLUME_L2_BLOCKS) {
+    card_stats.l2Misses++;
+    return 0;
+  }
+  volume_l2Transfer(i, data, 0);
+  card_stats.l2Hits++;
+  return 1;
+}
+
+/* Stores a FAT or directory block just read from the card, replacing the least recently used */
+static void volume_l2Store(uint32_t block, uint8_t* data) {
+  if (volume_l2Address == SRAM_NULL || !volume.isInitialized) return;
+  if (block >= volume.dataStartBlock && !volume_l2Dir) return;
+
+  uint8_t i, best = 0;
+  for (i = 1; i < VOLUME_L2_BLOCKS; i++) {
+    if ((uint8_t) (volume_l2Use - volume_l2LastUse[i]) > (uint8_t) (volume_l2Use - volume_l2LastUse[best])) {
+      best = i;
+    }
+  }
+  volume_l2Blocks[best] = block;
+  volume_l2Transfer(best, data, 1);
+}
+
+/* Write-through: updates the copy of a block in the second-level cache, if stored */
+static void volume_l2Update(uint32_t block, const uint8_t* data) {
+  if (volume_l2Address == SRAM_NULL) return;
+
+  uint8_t i = volume_l2Find(block);
+  if (i != VOLUME_L2_BLOCKS) {
+    volume_l2Transfer(i, (uint8_t*) data, 1);
+  }
+}
+#endif
+
+/*
+ * Writes a block of data to the SD-card, and to the mirror FAT block if specified
+ * Note that this function allows writing to the zero-block, so be careful!
+ */
+static void card_writeBlock(uint32_t block, const uint8_t* data_start, uint8_t mirror) {
+  const uint8_t* data;
+  const uint8_t* data_end = data_start + 512;
+  uint32_t start;
+
+  /* don't write anything, ever, if volume is not initialized */
+  if (!volume.isInitialized) return;
+
+  /* don't allow write to first block - TODO: Can this be removed? */
+  if (block == 0) return;
+  
+  while (true) {
+#if VOLUME_L2_BLOCKS
+    /* Update the second-level cache first, the card can not give up the bus while writing */
+    volume_l2Update(block, data_start);
+#endif
+    start = micros();
+
+    /* Continue writing if this is the next block of a multi-block write */
+    if (card_streamMode != CARD_STREAM_WRITE || card_streamBlock != block) {
+      if (card_streamEnabled && !mirror && block >= volume.dataStartBlock) {
+        /* 
+         * Start a multi-block write for data blocks
+         * Pre-erase the blocks up till the end of the cluster to speed up writing
+         */
+        card_command(SDMINFAT::CMD55, 0, 0XFF);
+        card_command(SDMINFAT::ACMD23, volume.blocksPerCluster - ((block - volume.dataStartBlock) & (volume.blocksPerCluster - 1)), 0XFF);
+        if (card_command(SDMINFAT::CMD25, block << card_notSDHCBlockShift, 0XFF)) goto fail;
+        card_streamMode = CARD_STREAM_WRITE;
+      } else {
+        /* use address if not SDHC card */
+        if (card_command(SDMINFAT::CMD24, block << card_notSDHCBlockShift, 0XFF)) goto fail;
+      }
+    }
+    spiSend((card_streamMode == CARD_STREAM_WRITE) ? SDMINFAT::WRITE_MULTIPLE_TOKEN : SDMINFAT::DATA_START_BLOCK);
+
+    /* Write data from buffer to SPI - optimized loop */
+    data = data_start;
+    do {
+      SPDR = *data;
+      data++;
+      spiWait();
+    } while (data != data_end);
+
+    spiRec();    /* dummy crc */
+    spiRec();    /* dummy crc */
+
+    /* Wait for programming of flash to complete */
+    if ((spiRec() & SDMINFAT::DATA_RES_MASK) != SDMINFAT::DATA_RES_ACCEPTED) goto fail;
+    if (!card_waitForData(SDMINFAT::DATA_IDLE_BLOCK)) goto fail;
+    if (card_streamMode == CARD_STREAM_WRITE) {
+      /* Status is checked once the multi-block write is stopped */
+      card_streamBlock = block + 1;
+    } else {
+      if (card_command(SDMINFAT::CMD13, 0, 0XFF)) goto fail;
+      if (spiRec()) goto fail;
+    }
+    card_stats.writeCount++;
+    card_stats.writeMicros += micros() - start;
+
+    /* Also write out a mirror block if specified */
+    if (mirror) {
+      mirror = 0;
+      block += volume.blocksPerFat;
+    } else {
+      /* Finished writing */
+      break;
+    }
+  }
+  return;
+
+fail:
+  card_stats.errors++;
+  card_streamMode = CARD_STREAM_NONE;
+  volume.isInitialized = 0;
+}
+
+#if VOLUME_CACHE_SLOTS > 1
+/*
+ * Additional cache slots, keeping FAT blocks that leave the cache while data blocks pass through it
+ * Modified FAT blocks are only written out when evicted or flushed
+ */
+typedef struct {
+  union SDMINFAT::cache_t buffer;  /* cached block data */
+  uint32_t blockNumber;            /* Logical number of block in the slot, 0xFFFFFFFF if none */
+  uint8_t dirty;                   /* Block was modified and must be written out */
+  uint8_t FATMirror;               /* Block is a mirrored FAT block */
+  uint8_t lastUse;                 /* Use counter value when last used, to find the least recently used slot */
+} CacheSlot;
+
+static CacheSlot volume_cacheSlots[VOLUME_CACHE_SLOTS - 1];
+static uint8_t volume_cacheUse = 0;
+
+/* Exchanges the cache contents with those of a slot */
+static void volume_swapSlot(CacheSlot* slot) {
+  uint8_t* a = volume_cacheBuffer.data;
+  uint8_t* b = slot->buffer.data;
+  uint8_t tmp;
+  uint16_t n = 512;
+  do {
+    tmp = *a;
+    *(a++) = *b;
+    *(b++) = tmp;
+  } while (--n);
+
+  uint32_t blockNumber = volume_cacheBlockNumber;
+  volume_cacheBlockNumber = slot->blockNumber;
+  slot->blockNumber = blockNumber;
+  tmp = volume_cacheDirty;
+  volume_cacheDirty = slot->dirty;
+  slot->dirty = tmp;
+  tmp = volume_cacheFATMirror;
+  volume_cacheFATMirror = slot->FATMirror;
+  slot->FATMirror = tmp;
+  slot->lastUse = ++volume_cacheUse;
+}
+
+/* Writes out a slot if it was modified */
+static void volume_writeSlot(CacheSlot* slot) {
+  if (slot->dirty) {
+    slot->dirty = 0;
+    card_writeBlock(slot->blockNumber, slot->buffer.data, slot->FATMirror);
+  }
+}
+#endif
+
 /* cache a file's directory entry
  * return pointer to cached entry */
 SDMINFAT::dir_t* file_readCacheDir(void) {
+#if VOLUME_CACHE_SLOTS > 1
+  /* Write out the FAT blocks kept in slots before the directory entry can refer to their clusters */
+  volume_flushCache();
+#endif
+  VOLUME_L2_DIR(1);
   volume_readCache(file_curDir.block);
+  VOLUME_L2_DIR(0);
   return volume_cacheBuffer.dir + file_curDir.index;
 }
 
@@ -132,6 +453,34 @@ uint8_t volume_updateCache(uint32_t blockNumber) {
   if (volume_cacheBlockNumber == blockNumber) {
     return 0;
   } else {
+#if VOLUME_CACHE_SLOTS > 1
+    /* Reserved and (first) FAT blocks are kept in a slot when they leave the cache */
+    uint8_t keep = (volume_cacheBlockNumber < (volume.fatStartBlock + volume.blocksPerFat));
+    CacheSlot* slot = volume_cacheSlots;
+    CacheSlot* victim = slot;
+    uint8_t i;
+    for (i = 0; i < (VOLUME_CACHE_SLOTS - 1); i++, slot++) {
+      /* Block is stored in a slot: bring it back into the cache */
+      if (slot->blockNumber == blockNumber) {
+        if (!keep && volume_cacheDirty) {
+          volume_writeCache();
+        }
+        volume_swapSlot(slot);
+        if (!keep) slot->blockNumber = 0xFFFFFFFF;
+        return 0;
+      }
+
+      /* Find the least recently used slot */
+      if ((uint8_t) (volume_cacheUse - slot->lastUse) > (uint8_t) (volume_cacheUse - victim->lastUse)) {
+        victim = slot;
+      }
+    }
+    if (keep) {
+      /* Store the block in the least recently used slot, writing out the block in it first */
+      volume_writeSlot(victim);
+      volume_swapSlot(victim);
+    }
+#endif
     /* Flush the cache if dirty */
     if (volume_cacheDirty) {
       volume_writeCache();
@@ -139,11 +488,85 @@ uint8_t volume_updateCache(uint32_t blockNumber) {
   
     /* Update the cache block number after potentially writing out */
     volume_cacheBlockNumber = blockNumber;
+    volume_cacheFATMirror = 0;
   
     return 1;
   }
 }
 
+/*
+ * Sends the command to read the block specified, without waiting for the data
+ * If this is the next block of a multi-block read, no new command is sent
+ * Returns 0 on failure
+ */
+static uint8_t card_readCommand(uint32_t blockNumber) {
+  card_readStart = micros();
+
+  /* Continue reading if this is the next block of a multi-block read */
+  if (card_streamMode != CARD_STREAM_READ || card_streamBlock != blockNumber) {
+    /* 
+     * Start a multi-block read for data blocks that are followed by more blocks
+     * of the same cluster. Other blocks (FAT, directory) are read one at a time.
+     */
+    uint8_t cmd = SDMINFAT::CMD17;
+    if (card_streamEnabled && blockNumber >= volume.dataStartBlock &&
+        ((blockNumber - volume.dataStartBlock + 1) & (volume.blocksPerCluster - 1))) {
+      cmd = SDMINFAT::CMD18;
+    }
+
+    /* Use address if not SDHC card */
+    if (card_command(cmd, blockNumber << card_notSDHCBlockShift, 0XFF)) return 0;
+    if (cmd == SDMINFAT::CMD18) card_streamMode = CARD_STREAM_READ;
+  }
+  return 1;
+}
+
+/* Handles a failed block read, the card must be initialized again */
+static void card_readFail(void) {
+  card_stats.errors++;
+  block_readState = BLOCK_READ_NONE;
+  card_streamMode = CARD_STREAM_NONE;
+  volume.isInitialized = 0;
+}
+
+/* Updates the read statistics once the card starts sending block data */
+static void card_readStarted(void) {
+  card_stats.readCount++;
+  card_stats.readMicros += micros() - card_readStart;
+}
+
+/*
+ * Sends the command to read the block specified and waits for the data to arrive
+ * If the block was requested using block_read_begin(), the pending read is used instead
+ * Returns 0 on failure
+ */
+static uint8_t card_readBegin(uint32_t blockNumber) {
+  if (block_readState == BLOCK_READ_NONE || block_readNumber != blockNumber) {
+    if (!card_readCommand(blockNumber)) goto fail;
+  }
+  if (block_readState != BLOCK_READ_READY) {
+    if (!card_waitForData(SDMINFAT::DATA_START_BLOCK)) goto fail;
+    card_readStarted();
+  }
+  block_readState = BLOCK_READ_NONE;
+  return 1;
+
+fail:
+  card_readFail();
+  return 0;
+}
+
+/*
+ * Finishes reading a block after all data and the first CRC byte are read
+ * During multi-block reads the second CRC byte must be read as well
+ */
+static void card_readEnd(uint32_t blockNumber) {
+  if (card_streamMode == CARD_STREAM_READ) {
+    spiRec();
+    card_streamBlock = blockNumber + 1;
+  }
+}
+
 /* 
  * Reads the block specified into the cache if it is not already loaded
  * If the current cache data still needs to be written out, this is done first
@@ -151,11 +574,11 @@ uint8_t volume_updateCache(uint32_t blockNumber) {
 void volume_readCache(uint32_t blockNumber) {
   uint8_t* data = volume_cacheBuffer.data-1;
   uint8_t* data_end = volume_cacheBuffer.data + 512;
-  if (volume_updateCache(blockNumber)) {
-    /* Use address if not SDHC card */
-    if (card_command(SDMINFAT::CMD17, blockNumber << card_notSDHCBlockShift, 0XFF)) goto fail;
-    if (!card_waitForData(SDMINFAT::DATA_START_BLOCK)) goto fail;
-
+  if (!volume_updateCache(blockNumber)) return;
+#if VOLUME_L2_BLOCKS
+  if (volume_l2Read(blockNumber, volume_cacheBuffer.data)) return;
+#endif
+  if (card_readBegin(blockNumber)) {
     /* 
      * Read the data one byte at a time
      * Read one extra byte at the end which is discarded
@@ -167,12 +590,69 @@ void volume_readCache(uint32_t blockNumber) {
       if (data == data_end) break;
       *data = SPDR;
     }
+    card_readEnd(blockNumber);
+#if VOLUME_L2_BLOCKS
+    volume_l2Store(blockNumber, volume_cacheBuffer.data);
+#endif
   }
-  return;
-  
-fail:
-  volume.isInitialized = 0;
-  return;
+}
+
+/* 
+ * Requests a block to be read without waiting for the card to prepare the data
+ * Nothing is sent if the block is already cached or requested
+ */
+uint8_t block_read_begin(uint32_t blockNumber) {
+  if (block_readState != BLOCK_READ_NONE) {
+    if (block_readNumber == blockNumber) return 1;
+    card_streamStop();
+  }
+  block_readNumber = blockNumber;
+  if (blockNumber == volume_cacheBlockNumber) return 1;
+  if (!volume.isInitialized) return 0;
+  if (!card_readCommand(blockNumber)) {
+    card_readFail();
+    return 0;
+  }
+  block_readState = BLOCK_READ_BUSY;
+  return 1;
+}
+
+/*
+ * Checks whether the card is done preparing the block data, receiving one byte at most
+ * Errors and timeouts (~200 ms) end the read, the failure is reported by block_read_finish()
+ */
+uint8_t block_read_poll(void) {
+  uint8_t token;
+  if (block_readState != BLOCK_READ_BUSY) return 1;
+  token = spiRec();
+  if (token == SDMINFAT::DATA_START_BLOCK) {
+    card_readStarted();
+    block_readState = BLOCK_READ_READY;
+  } else if (token != SDMINFAT::DATA_IDLE_BLOCK || (micros() - card_readStart) > 200000) {
+    card_readFail();
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+/* Reads the requested block into the cache, waiting for the data if needed */
+uint8_t* block_read_finish(void) {
+  volume_readCache(block_readNumber);
+  return volume.isInitialized ? volume_cacheBuffer.data : NULL;
+}
+
+/* Reads a block from the card, comparing it with the data specified. Returns 1 if equal */
+static uint8_t card_compareBlock(uint32_t blockNumber, const uint8_t* data) {
+  const uint8_t* data_end = data + 512;
+  uint8_t equal = 1;
+  if (!card_readBegin(blockNumber)) return 0;
+  do {
+    if (spiRec() != *data) equal = 0;
+  } while (++data != data_end);
+  spiRec();    /* first crc byte */
+  card_readEnd(blockNumber);
+  return equal;
 }
 
 /*
@@ -194,53 +674,25 @@ void volume_writeCache() {
  * Note that this function allows writing to the zero-block, so be careful!
  */
 void volume_writeCache(uint32_t block) {
-  uint8_t* data;
-  uint8_t* data_end = volume_cacheBuffer.data + 512;
+  uint8_t mirror = volume_cacheFATMirror;
   volume_cacheDirty = 0;
+  volume_cacheFATMirror = 0;
   volume_cacheBlockNumber = block;
+  card_writeBlock(block, volume_cacheBuffer.data, mirror);
+}
 
-  /* don't write anything, ever, if volume is not initialized */
-  if (!volume.isInitialized) return;
-
-  /* don't allow write to first block - TODO: Can this be removed? */
-  if (block == 0) return;
-  
-  while (true) {
-
-    /* use address if not SDHC card */
-    if (card_command(SDMINFAT::CMD24, block << card_notSDHCBlockShift, 0XFF)) goto fail;
-    spiSend(SDMINFAT::DATA_START_BLOCK);
-
-    /* Write data from buffer to SPI - optimized loop */
-    data = volume_cacheBuffer.data;
-    do {
-      SPDR = *data;
-      data++;
-      spiWait();
-    } while (data != data_end);
-
-    spiRec();    /* dummy crc */
-    spiRec();    /* dummy crc */
-
-    /* Wait for programming of flash to complete */
-    if ((spiRec() & SDMINFAT::DATA_RES_MASK) != SDMINFAT::DATA_RES_ACCEPTED) goto fail;
-    if (!card_waitForData(SDMINFAT::DATA_IDLE_BLOCK)) goto fail;
-    if (card_command(SDMINFAT::CMD13, 0, 0XFF)) goto fail;
-    if (spiRec()) goto fail;
-
-    /* Also write out a mirror block if specified */
-    if (volume_cacheFATMirror) {
-      volume_cacheFATMirror = 0;
-      block += volume.blocksPerFat;
-    } else {
-      /* Finished writing */
-      break;
-    }
+/* Writes out the current cached block and all cache slots that were modified */
+void volume_flushCache(void) {
+  if (volume_cacheDirty) {
+    volume_writeCache();
   }
-  return;
-
-fail:
-  volume.isInitialized = 0;
+#if VOLUME_CACHE_SLOTS > 1
+  CacheSlot* slot = volume_cacheSlots;
+  uint8_t i = (VOLUME_CACHE_SLOTS - 1);
+  do {
+    volume_writeSlot(slot++);
+  } while (--i);
+#endif
 }
 
 static void volume_fatLoad(uint32_t cluster) {
@@ -250,8 +702,8 @@ static void volume_fatLoad(uint32_t cluster) {
   /* Read the FAT Block into the cache */
   volume_readCache(volume.fatStartBlock + (cluster >> (7 + volume.isfat16)));
   
-  /* If multiple FAT, mark current block in cache mirrored */
-  volume_cacheFATMirror = volume.isMultiFat;
+  /* If multiple FAT, mark current block in cache mirrored, unless mirroring is done on commit */
+  volume_cacheFATMirror = volume.isMultiFat && !volume_atomic;
 }
 
 /* Fetch a FAT entry, returns True when successful, False when the cluster is an EOC */
@@ -271,25 +723,197 @@ uint8_t volume_fatGet(uint32_t cluster, uint32_t* value) {
   return 1;
 }
 
+/* Gets the next cluster in the FAT cluster chain, returns 0 when the cluster is the last one */
+static uint32_t volume_fatNext(uint32_t cluster) {
+  uint32_t next;
+  if (!volume_fatGet(cluster, &next)) return 0;
+  if (next >= (volume.isfat16 ? SDMINFAT::FAT16EOC_MIN : SDMINFAT::FAT32EOC_MIN)) return 0;
+  return next;
+}
+
+/* Adds the cluster at the index specified to the cluster runs of the file, if it follows the runs known */
+static void file_extentAdd(uint32_t index, uint32_t cluster) {
+  FileExtent* e = file_extents + file_extentCount - 1;
+  uint32_t end = file_extentCount ? (e->index + e->count) : 0;
+  if (index != end) return;
+  if (file_extentCount && (e->cluster + e->count) == cluster) {
+    e->count++;
+  } else if (file_extentCount < FILE_EXTENT_COUNT) {
+    e++;
+    e->index = index;
+    e->cluster = cluster;
+    e->count = 1;
+    file_extentCount++;
+  }
+}
+
 /* Store a FAT entry */
+/*
+ * Sets or clears the clean shutdown bit in the second entry of the FAT
+ * The bit is cleared on the card before the first FAT change of an atomic update,
+ * and set in both FATs again once all changes are mirrored
+ */
+static void volume_setClean(uint8_t clean) {
+  volume_readCache(volume.fatStartBlock);
+  if (volume.isfat16) {
+    if (clean) {
+      volume_cacheBuffer.fat16[1] |= SDMINFAT::FAT16_CLEAN_SHUTDOWN;
+    } else {
+      volume_cacheBuffer.fat16[1] &= ~SDMINFAT::FAT16_CLEAN_SHUTDOWN;
+    }
+  } else {
+    if (clean) {
+      volume_cacheBuffer.fat32[1] |= SDMINFAT::FAT32_CLEAN_SHUTDOWN;
+    } else {
+      volume_cacheBuffer.fat32[1] &= ~SDMINFAT::FAT32_CLEAN_SHUTDOWN;
+    }
+  }
+  volume_cacheFATMirror = clean && volume.isMultiFat;
+  volume_writeCache();
+}
+
 void volume_fatPut(uint32_t cluster, uint32_t value) {
   /* do not put if reserved cluster */
   if (cluster < 2) return;
 
+  /* In atomic mode, mark the FAT as being updated before changing it */
+  uint8_t atomic = volume_atomic && volume.isMultiFat;
+  if (atomic && !volume_mirrorLast) {
+    volume_setClean(0);
+  }
+
   /* calculate block address for entry */
   volume_fatLoad(cluster);
 
-  /* store entry */
+  /* In atomic mode, remember the blocks changed to mirror them on commit */
+  if (atomic) {
+    if (!volume_mirrorLast || volume_cacheBlockNumber < volume_mirrorFirst) {
+      volume_mirrorFirst = volume_cacheBlockNumber;
+    }
+    if (volume_cacheBlockNumber > volume_mirrorLast) {
+      volume_mirrorLast = volume_cacheBlockNumber;
+    }
+  }
+
+  /* store entry, keeping the old value to track free clusters */
+  uint32_t old;
   if (volume.isfat16) {
+    old = volume_cacheBuffer.fat16[cluster & 0XFF];
     volume_cacheBuffer.fat16[cluster & 0XFF] = value;
   } else {
+    old = volume_cacheBuffer.fat32[cluster & 0X7F] & SDMINFAT::FAT32MASK;
     volume_cacheBuffer.fat32[cluster & 0X7F] = value;
   }
 
+  /* Update the free cluster hints when a cluster is allocated or freed */
+  if (!old != !value) {
+    if (value) {
+      if (volume.freeClusterCount != SDMINFAT::FSINFO_UNKNOWN) volume.freeClusterCount--;
+    } else {
+      if (volume.freeClusterCount != SDMINFAT::FSINFO_UNKNOWN) volume.freeClusterCount++;
+      if (cluster < volume.freeClusterHint) volume.freeClusterHint = cluster;
+    }
+    volume.fsInfoChanged = 1;
+  }
+
   /* Mark current cache dirty since we wrote to it */
   volume_cacheDirty = 1;
 }
 
+/* Sets the SPI clock rate, speed 0 is f_osc/2, speed 6 is f_osc/128 */
+static void card_setSpeed(uint8_t speed) {
+  if ((speed & 0x1) || (speed == 6)) {
+    SPSR &= ~(1 << SPI2X);
+  } else {
+    SPSR |= (1 << SPI2X);
+  }
+  SPCR &= ~((1 <<SPR1) | (1 << SPR0));
+  SPCR |= (speed & 4 ? (1 << SPR1) : 0) | (speed & 2 ? (1 << SPR0) : 0);
+}
+
+/* Computes the CRC7 byte of a command, only needed while CRC checking is turned on */
+static uint8_t card_commandCRC(uint8_t cmd, uint32_t arg) {
+  uint8_t crc = 0;
+  uint8_t i, b, d;
+  for (i = 0; i < 5; i++) {
+    d = i ? (uint8_t) (arg >> (32 - 8 * i)) : (cmd | 0x40);
+    for (b = 0; b < 8; b++) {
+      crc <<= 1;
+      if ((d ^ crc) & 0x80) crc ^= 0x09;
+      d <<= 1;
+    }
+  }
+  return (crc << 1) | 1;
+}
+
+/*
+ * Reads the first block of the card with CRC checking turned on
+ * Returns 1 if the data was received without errors at the current SPI speed
+ */
+static uint8_t card_verifyRead(void) {
+  uint8_t result = 0;
+  uint16_t crc = 0;
+  uint16_t i;
+  if (card_command(SDMINFAT::CMD59, 1, card_commandCRC(SDMINFAT::CMD59, 1))) return 0;
+  if (!card_command(SDMINFAT::CMD17, 0, card_commandCRC(SDMINFAT::CMD17, 0)) && card_waitForData(SDMINFAT::DATA_START_BLOCK)) {
+    /* Compute the CRC16 (CCITT) of the data while receiving it, then compare with the one sent */
+    for (i = 0; i < 512; i++) {
+      crc = (uint8_t) (crc >> 8) | (crc << 8);
+      crc ^= spiRec();
+      crc ^= (uint8_t) (crc & 0xFF) >> 4;
+      crc ^= crc << 12;
+      crc ^= (crc & 0xFF) << 5;
+    }
+    i = spiRec() << 8;
+    i |= spiRec();
+    result = (i == crc);
+  }
+
+  /* Turn CRC checking off again, all other transfers use dummy CRC bytes */
+  if (card_command(SDMINFAT::CMD59, 0, card_commandCRC(SDMINFAT::CMD59, 0))) result = 0;
+  return result;
+}
+
+/* Maximum transfer rate mantissa (times 10) of the TRAN_SPEED field in the CSD register */
+static const uint8_t card_tranSpeedValues[16] PROGMEM = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+
+/*
+ * Selects the fastest SPI speed the card supports according to the CSD register
+ * The speed is verified with a CRC-checked read, using slower speeds while that fails
+ * Returns 0 if the card could not be read at any speed
+ */
+static uint8_t card_negotiateSpeed(void) {
+  uint8_t speed = card_speedLimit;
+  uint8_t tran_speed, unit;
+  uint32_t max_khz = 0;
+
+  /* Read the TRAN_SPEED field (byte 3) of the CSD register, skip the rest and the CRC */
+  if (!card_command(SDMINFAT::CMD9, 0, 0XFF) && card_waitForData(SDMINFAT::DATA_START_BLOCK)) {
+    tran_speed = spiRecNr(4);
+    spiRecNr(14);
+
+    /* Transfer rate unit: 0 = 100kbit/s, 1 = 1Mbit/s, 2 = 10Mbit/s, 3 = 100Mbit/s */
+    max_khz = pgm_read_byte(card_tranSpeedValues + ((tran_speed >> 3) & 0xF)) * 10;
+    for (unit = tran_speed & 0x7; unit && (unit <= 3); unit--) max_khz *= 10;
+  }
+
+  /* Skip speeds faster than the card supports, if known */
+  if (max_khz) {
+    while ((speed < 6) && ((F_CPU / 2000) >> speed) > max_khz) speed++;
+  }
+
+  /* Verify the speed, falling back to slower speeds on errors */
+  for (;;) {
+    card_setSpeed(speed);
+    if (card_verifyRead()) break;
+    card_stats.errors++;
+    if (speed++ == 6) return 0;
+  }
+  card_speed = speed;
+  card_speedErrors = card_stats.errors;
+  return 1;
+}
+
 /* Ensure card is initialized by opening an arbitrary (non-existent) file */
 uint8_t volume_init(uint8_t resetPosition) {
   const char name_none[1] = {0};
@@ -298,6 +922,8 @@ uint8_t volume_init(uint8_t resetPosition) {
   
   /* Prepare for reading the root directory entries */
   if (resetPosition) {
+    file_allocLast = 0;
+    file_extentCount = 0;
     file_position = 0;
     file_curCluster = volume.rootCluster;
     file_isroot16dir = volume.isfat16;
@@ -305,46 +931,243 @@ uint8_t volume_init(uint8_t resetPosition) {
   return 1;
 }
 
-/**
- * The flush() call causes all modified data and directory fields
- * to be written to the storage device. With save, the file name
- * to write to can be specified as well
- */
-void file_save(char filename[8]) {
-  SDMINFAT::dir_t* p = file_readCacheDir();
+/* Writes the free cluster hints to the FSInfo block if they changed */
+static void volume_writeFSInfo(void) {
+  if (volume.fsInfoChanged && volume.fsInfoBlock) {
+    volume.fsInfoChanged = 0;
+    volume_readCache(volume.fsInfoBlock);
+    volume_cacheBuffer.fsinfo.freeCount = volume.freeClusterCount;
+    volume_cacheBuffer.fsinfo.nextFree = volume.freeClusterHint;
+    volume_writeCache();
+  }
+}
+
+/*
+ * Completes an update after the directory entry is written
+ * In atomic mode the FAT blocks changed are copied to the mirror FAT, after which
+ * the FAT is marked clean again. Then the free cluster hints are written out.
+ */
+static void volume_commitFAT(void) {
+  uint32_t block;
+  if (volume_mirrorLast) {
+    volume_flushCache();
+    for (block = volume_mirrorFirst; block <= volume_mirrorLast && volume.isInitialized; block++) {
+      volume_readCache(block);
+      volume_writeCache(block + volume.blocksPerFat);
+    }
+    volume_mirrorLast = 0;
+    volume_setClean(1);
+  }
+  volume_writeFSInfo();
+}
+
+/*
+ * Checks the clean shutdown bit of the FAT, which is cleared while an atomic update is in progress
+ * If an update was interrupted, the mirror FAT is made equal to the first FAT again.
+ * Clusters allocated by the interrupted update that no file refers to stay allocated.
+ */
+static void volume_recover(void) {
+  uint32_t block;
+  uint8_t clean;
+  if (!volume.isMultiFat) return;
+  volume_readCache(volume.fatStartBlock);
+  if (volume.isfat16) {
+    clean = (volume_cacheBuffer.fat16[1] & SDMINFAT::FAT16_CLEAN_SHUTDOWN) != 0;
+  } else {
+    clean = (volume_cacheBuffer.fat32[1] & SDMINFAT::FAT32_CLEAN_SHUTDOWN) != 0;
+  }
+  if (clean) return;
+
+  /* Only write the mirror blocks that differ */
+  for (block = volume.fatStartBlock; block < (volume.fatStartBlock + volume.blocksPerFat) && volume.isInitialized; block++) {
+    volume_readCache(block);
+    if (!card_compareBlock(block + volume.blocksPerFat, volume_cacheBuffer.data)) {
+      volume_writeCache(block + volume.blocksPerFat);
+    }
+  }
+  volume_setClean(1);
+}
+
+void volume_setAtomic(uint8_t enabled) {
+  /* Changes made so far are mirrored right away when disabling */
+  if (!enabled) {
+    volume_flushCache();
+    volume_commitFAT();
+  }
+  volume_atomic = enabled;
+}
+
+static void file_releaseReserved(void);
+
+/**
+ * The flush() call causes all modified data and directory fields
+ * to be written to the storage device. With save, the file name
+ * to write to can be specified as well
+ */
+void file_save(char filename[8]) {
+  /* Write out file data and FAT changes before the directory entry refers to them */
+  file_releaseReserved();
+  volume_flushCache();
+
+  SDMINFAT::dir_t* p = file_readCacheDir();
+
+  /* update file size */
+  p->fileSize = file_size;
+
+  /* update first cluster fields */
+  memcpy(p->name, filename, 8);
+  volume_writeCache();
+  volume_dirVersion++;
+  volume_commitFAT();
+  card_streamStop();
+}
+
+/* Frees the file content clusters and frees the directory entry of the current file */
+/* Note: MUST be performed right after opening a file, do not write/read! */
+void file_delete(void) {
+  /* Delete contents of file */
+  file_truncate();
+  
+  /* Set first char of filename to mark deletion, then save */
+  char filename[8];
+  filename[0] = SDMINFAT::DIR_NAME_DELETED;
+  file_save(filename);
+}
+
+/**
+ * The flush() call causes all modified data and directory fields
+ * to be written to the storage device.
+ */
+void file_flush(void) {
+  /* Write out file data and FAT changes before the directory entry refers to them */
+  file_releaseReserved();
+  volume_flushCache();
+
+  SDMINFAT::dir_t* p = file_readCacheDir();
+
+  /* update file size */
+  p->fileSize = file_size;
+
+  /* update first cluster fields */
+  volume_writeCache();
+  volume_commitFAT();
+
+  /* Make sure all data is written out before returning */
+  card_streamStop();
+}
+
+/*
+ * Scans a directory for an entry with the 8.3 format name specified, 0 being the root directory
+ * Directory entries are matched when directory is set, file entries otherwise.
+ * The directory entry found, or the first free entry, is stored in file_curDir.
+ * Returns 1 when found, 2 when a free entry was found and 0 when neither was found.
+ * When 0 is returned, the position is at the end of the last cluster of the directory.
+ */
+static uint8_t dir_scan(uint32_t dirCluster, const unsigned char* name, uint8_t directory) {
+  SDMINFAT::dir_t* p;
+  uint8_t index;
+  uint8_t result = 0;
+  uint32_t clusterMask = ((uint32_t) volume.blocksPerCluster << 9) - 1;
+
+  /* set to the start of the directory */
+  file_allocLast = 0;
+  file_extentCount = 0;
+  file_position = 0;
+  file_isroot16dir = volume.isfat16 && !dirCluster;
+  file_curCluster = dirCluster ? dirCluster : volume.rootCluster;
+
+  VOLUME_L2_DIR(1);
+  while (volume.isInitialized) {
+    /* Stop at the end of the directory */
+    if (file_isroot16dir) {
+      if (file_position >= volume.rootSize) break;
+    } else if (file_position && !(file_position & clusterMask) && !volume_fatNext(file_curCluster)) {
+      break;
+    }
+
+    /* Move the reader to the next 32 bytes, once it reaches 512 the next block is read */
+    index = (file_position >> 5) & 0xF;
+    p = (SDMINFAT::dir_t*) file_read(32);
+
+    /* Is this our entry? */
+    if (!memcmp(name, p->name, 11) && (directory ? (p->attributes & SDMINFAT::DIR_ATT_DIRECTORY) : p->isFile())) {
+      file_curDir.block = volume_cacheBlockNumber;
+      file_curDir.index = index;
+      result = 1;
+      break;
+    }
+
+    char c = p->name[0];
+    if ((c == SDMINFAT::DIR_NAME_FREE) || (c == SDMINFAT::DIR_NAME_DELETED)) {
+      /* Store the first free entry block and index */
+      if (!result) {
+        result = 2;
+        file_curDir.block = volume_cacheBlockNumber;
+        file_curDir.index = index;
+      }
+      /* Check for end of directory */
+      if (c == SDMINFAT::DIR_NAME_FREE) break;
+    }
+  }
+  VOLUME_L2_DIR(0);
+  return result;
+}
+
+/* Opens or creates a file in a directory, 0 being the root directory */
+static uint8_t file_openIn(uint32_t dirCluster, const unsigned char* name, uint8_t mode) {
+  SDMINFAT::dir_t* p;
+
+  /* Locate this file in the directory */
+  uint8_t result = dir_scan(dirCluster, name, 0);
+  if (!volume.isInitialized) return 0;
+
+  /* Create a new file entry */
+  if (result != 1) {
+    /* only create new files when CREATING is set */
+    if (!(mode & SDMIN_FILE_CREATE)) return 0;
+    /* can not create new root clusters on FAT16 */
+    if (!result && file_isroot16dir) return 0;
 
-  /* update file size */
-  p->fileSize = file_size;
+    /* No usable entry was found - append a new cluster to the directory */
+    if (!result) {
+      /* Calling cacheCurrentBlock at the end of the last cluster appends a new cluster to the chain */
+      /* Note: cache is not dirty after this call, we can safely discard it! */
+      volume_cacheCurrentBlock(1);
 
-  /* update first cluster fields */
-  memcpy(p->name, filename, 8);
-  volume_writeCache();
-}
+      /* use first entry in cluster */
+      file_curDir.block = volume_cacheBlockNumber;
+      file_curDir.index = 0;
 
-/* Frees the file content clusters and frees the directory entry of the current file */
-/* Note: MUST be performed right after opening a file, do not write/read! */
-void file_delete(void) {
-  /* Delete contents of file */
-  file_truncate();
-  
-  /* Set first char of filename to mark deletion, then save */
-  char filename[8];
-  filename[0] = SDMINFAT::DIR_NAME_DELETED;
-  file_save(filename);
-}
+      /* Fill cache with zero data */
+      /* Loop takes less flash than memset(volume_cacheBuffer_.data, 0, 512); */
+      for (uint16_t d = 0; d < 512; d++) {
+        volume_cacheBuffer.data[d] = 0;
+      }
 
-/**
- * The flush() call causes all modified data and directory fields
- * to be written to the storage device.
- */
-void file_flush(void) {
-  SDMINFAT::dir_t* p = file_readCacheDir();
+      /* Write this zero cache to all the clusters */
+      uint8_t i = volume.blocksPerCluster;
+      do {
+        volume_writeCache();
+        volume_cacheBlockNumber++;
+      } while (--i);
+    }
+    p = file_readCacheDir();
 
-  /* update file size */
-  p->fileSize = file_size;
+    /* initialize as empty file */
+    memset(p, 0, sizeof(SDMINFAT::dir_t));
+    memcpy(p->name, name, 11);
 
-  /* update first cluster fields */
-  volume_writeCache();
+    /* set timestamps */
+    p->lastWriteDate = p->lastAccessDate = p->creationDate = SDMINFAT::FAT_DEFAULT_DATE;
+    p->lastWriteTime = p->creationTime = SDMINFAT::FAT_DEFAULT_TIME;
+
+    /* force write of entry to SD */
+    volume_writeCache();
+    volume_dirVersion++;
+
+  } /* Entry creation end */
+
+  return file_open_entry(mode);
 }
 
 uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
@@ -361,6 +1184,9 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
 
   /* If card/volume is not initialized, initialize it */
   if (!volume.isInitialized) {
+    /* Any transfer in progress was aborted */
+    card_streamMode = CARD_STREAM_NONE;
+    block_readState = BLOCK_READ_NONE;
 
     /* Initialize SPI port */
     SPI_DDR = (SPI_DDR & ~SPI_MASK) | SPI_INIT_DDR;
@@ -417,14 +1243,16 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
       if ((spiRec() & 0XC0) != 0XC0) card_notSDHCBlockShift = 9;
     }
 
-    /* Set SPI SCK Speed */
-#if (SCK_SPEED & 0x1) || (SCK_SPEED == 6)
-    SPSR &= ~(1 << SPI2X);
-#else
-    SPSR |= (1 << SPI2X);
-#endif
-    SPCR &= ~((1 <<SPR1) | (1 << SPR0));
-    SPCR |= (SCK_SPEED & 4 ? (1 << SPR1) : 0) | (SCK_SPEED & 2 ? (1 << SPR0) : 0);
+    /* 
+     * Set SPI SCK Speed, negotiated with the card
+     * If errors occurred since the previous negotiation, start one speed slower
+     */
+    if (card_stats.errors == card_speedErrors) {
+      card_speedLimit = SCK_SPEED;
+    } else if (card_speed < 6) {
+      card_speedLimit = card_speed + 1;
+    }
+    if (!card_negotiateSpeed()) return 0;
 
     /* Initialize an available partition volume, first try 1, then 0 */
     for (uint8_t part = 1;; part--) {
@@ -436,6 +1264,17 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
       /* if part == 0 assume super floppy with FAT boot sector in block zero
        * if part > 0 assume mbr volume with partition table */
       volume_cacheBlockNumber = 0XFFFFFFFF;
+      memset(dir_cache, 0, sizeof(dir_cache));
+#if VOLUME_CACHE_SLOTS > 1
+      for (uint8_t i = 0; i < (VOLUME_CACHE_SLOTS - 1); i++) {
+        volume_cacheSlots[i].blockNumber = 0XFFFFFFFF;
+        volume_cacheSlots[i].dirty = 0;
+      }
+#endif
+#if VOLUME_L2_BLOCKS
+      /* The card may have been swapped, forget all blocks of the previous volume */
+      memset(volume_l2Blocks, 0xFF, sizeof(volume_l2Blocks));
+#endif
       volume_readCache(0);
       if (part) {
         SDMINFAT::part_t* p = &volume_cacheBuffer.mbr.part[part-1];
@@ -481,12 +1320,38 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
 
       /* FAT type is determined by cluster count */
       volume.isfat16 = (volume.clusterLast <= 65525);
+      volume.fsInfoBlock = 0;
       if (!volume.isfat16) {  
         volume.rootCluster = bpb->fat32RootCluster;
+        if (bpb->fat32FSInfo) volume.fsInfoBlock = volumeStartBlock + bpb->fat32FSInfo;
       }
 
       /* Success! */
       volume.isInitialized = 1;
+      volume_dirVersion++;
+
+      /* Read the free cluster hints from the FSInfo block, if available and valid */
+      volume.freeClusterHint = 2;
+      volume.freeClusterCount = SDMINFAT::FSINFO_UNKNOWN;
+      volume.fsInfoChanged = 0;
+      if (volume.fsInfoBlock) {
+        volume_readCache(volume.fsInfoBlock);
+        SDMINFAT::fsinfo_t* fsinfo = &volume_cacheBuffer.fsinfo;
+        if (fsinfo->leadSignature == SDMINFAT::FSINFO_LEAD_SIG && fsinfo->structSignature == SDMINFAT::FSINFO_STRUCT_SIG) {
+          if (fsinfo->nextFree >= 2 && fsinfo->nextFree <= volume.clusterLast) {
+            volume.freeClusterHint = fsinfo->nextFree;
+          }
+          if (fsinfo->freeCount <= volume.clusterLast) {
+            volume.freeClusterCount = fsinfo->freeCount;
+          }
+        } else {
+          volume.fsInfoBlock = 0;
+        }
+      }
+
+      /* Repair the mirror FAT if an atomic update was interrupted */
+      volume_mirrorLast = 0;
+      if (volume_atomic) volume_recover();
       break;
     }
   } /* Initialization end */
@@ -498,85 +1363,135 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
     if (filename_83fmt[fi] < 32) return 0;
   } while (fi--);
 
-  /* set to root directory */
-  file_position = 0;
-  file_isroot16dir = volume.isfat16;
-  file_curCluster = volume.rootCluster;
-
-  /* Locate this file on the root volume */
-  SDMINFAT::dir_t* p;
-  uint8_t index = 0xF;
-  uint8_t entryFound = 0;
-  uint8_t fileFound = 0;
-  do {
-    /* Read sectors of 32 bytes, when it reaches the final sector (16) go to the next block */
-    index++;
-    index &= 0xF;
-
-    /* Move the reader to the next 32 bytes, once it reaches 512 the next block is read */
-    p = (SDMINFAT::dir_t*) file_read(32);
+  return file_openIn(0, filename_83fmt, mode);
+}
 
-    /* Is this our file? */
-    fileFound = (!memcmp(filename_83fmt, p->name, 11) && p->isFile());
+/*
+ * Converts the next name in a path into the 8.3 format, converting to upper case
+ * Returns a pointer to the remainder of the path, or NULL if the name is invalid
+ */
+static const char* file_pathName(const char* path, unsigned char* name) {
+  uint8_t i = 0;    /* position in the name */
+  uint8_t end = 8;  /* end of the name or extension currently converted */
+  char c;
+  memset(name, ' ', 11);
+  while ((c = *path) && c != '/') {
+    path++;
+    if (c == '.') {
+      /* Extension follows, only once */
+      if (end == 11) return NULL;
+      i = 8;
+      end = 11;
+      continue;
+    }
+    if (i == end || (c & 0x80) || c < 32) return NULL;
+    if (c >= 'a' && c <= 'z') c -= ('a' - 'A');
+    name[i++] = c;
+  }
+  return (name[0] != ' ') ? path : NULL;
+}
 
-    char c = p->name[0];
-    if (fileFound || (c == SDMINFAT::DIR_NAME_FREE) || (c == SDMINFAT::DIR_NAME_DELETED)) {
-      /* Store found entry block and index */
-      if (!entryFound || fileFound) {
-        entryFound = 1;
-        file_curDir.block = volume_cacheBlockNumber;
-        file_curDir.index = index;
-      }
-      /* Check for completion or end of directory */
-      if (c == SDMINFAT::DIR_NAME_FREE) break;
+/* Looks up the first cluster of a subdirectory, using the cache of directories resolved before */
+static uint32_t dir_resolve(uint32_t dirCluster, const unsigned char* name) {
+  DirCacheEntry* e = dir_cache;
+  uint8_t i;
+  for (i = 0; i < DIR_CACHE_COUNT; i++, e++) {
+    if (e->cluster && e->parent == dirCluster && !memcmp(e->name, name, 11)) {
+      return e->cluster;
     }
-  } while (volume.isInitialized && !fileFound);
+  }
 
-  /* Create a new file entry */
-  if (!fileFound) {
-    /* only create new files when CREATING is set */
-    if (!(mode & SDMIN_FILE_CREATE)) return 0;
-    /* can not create new root clusters on FAT16 */
-    if (!entryFound && volume.isfat16) return 0;
+  /* Not cached, scan the parent directory and store the result */
+  if (dir_scan(dirCluster, name, 1) != 1) return 0;
+  e = dir_cache + dir_cacheNext;
+  dir_cacheNext = (dir_cacheNext + 1) % DIR_CACHE_COUNT;
+  e->parent = dirCluster;
+  e->cluster = file_readCacheDir()->firstCluster();
+  memcpy(e->name, name, 11);
+  return e->cluster;
+}
 
-    /* No usable entry was found - append a new cluster root cluster */
-    if (!entryFound) {
-      /* Calling cacheCurrentBlock appends a new cluster to the chain */
-      /* Note: cache is not dirty after this call, we can safely discard it! */
-      file_position = 0;
-      volume_cacheCurrentBlock(1);
+uint8_t file_open_path(const char* path, uint8_t mode) {
+  unsigned char name[11];
+  uint32_t dirCluster = 0;
+
+  /* Initialize the volume if needed */
+  if (!volume.isInitialized && !volume_init(0)) return 0;
+  if (*path == '/') path++;
+
+  /* Resolve all directories in the path, then open the file in the last one */
+  for (;;) {
+    path = file_pathName(path, name);
+    if (!path) return 0;
+    if (!*path) return file_openIn(dirCluster, name, mode);
+    path++;
+    dirCluster = dir_resolve(dirCluster, name);
+    if (!dirCluster) return 0;
+  }
+}
 
-      /* use first entry in cluster */
-      file_curDir.block = volume_cacheBlockNumber;
-      file_curDir.index = 0;
+void dir_iterator_begin(DirIterator* it, uint32_t dirCluster, const char* ext) {
+  it->isroot16 = volume.isfat16 && !dirCluster;
+  it->cluster = dirCluster ? dirCluster : volume.rootCluster;
+  it->position = 0;
+  it->ext = ext;
+  it->end = 0;
+}
 
-      /* Fill cache with zero data */
-      /* Loop takes less flash than memset(volume_cacheBuffer_.data, 0, 512); */
-      for (uint16_t d = 0; d < 512; d++) {
-        volume_cacheBuffer.data[d] = 0;
+uint8_t dir_iterator_next(DirIterator* it, DirEntryInfo* info) {
+  SDMINFAT::dir_t* p;
+  uint32_t block;
+  uint8_t index;
+  char c;
+
+  while (!it->end && volume.isInitialized) {
+    index = (it->position >> 5) & 0xF;
+    if (it->isroot16) {
+      /* FAT16 root directory blocks follow one after the other */
+      if (it->position >= volume.rootSize) break;
+      block = volume.rootCluster + (it->position >> 9);
+    } else {
+      /* Move on to the next cluster of the directory when the current one is done */
+      if (it->position && !(it->position & (((uint32_t) volume.blocksPerCluster << 9) - 1))) {
+        it->cluster = volume_fatNext(it->cluster);
+        if (!it->cluster) break;
       }
-
-      /* Write this zero cache to all the clusters */
-      uint8_t i = volume.blocksPerCluster;
-      do {
-        volume_writeCache();
-        volume_cacheBlockNumber++;
-      } while (--i);
+      block = volume_firstClusterBlock(it->cluster) + ((it->position >> 9) & (volume.blocksPerCluster - 1));
     }
-    p = file_readCacheDir();
-
-    /* initialize as empty file */
-    memset(p, 0, sizeof(SDMINFAT::dir_t));
-    memcpy(p->name, filename_83fmt, 11);
 
-    /* set timestamps */
-    p->lastWriteDate = p->lastAccessDate = p->creationDate = SDMINFAT::FAT_DEFAULT_DATE;
-    p->lastWriteTime = p->creationTime = SDMINFAT::FAT_DEFAULT_TIME;
+    /* Go by all remaining entries in this block */
+    VOLUME_L2_DIR(1);
+    volume_readCache(block);
+    VOLUME_L2_DIR(0);
+    p = volume_cacheBuffer.dir + index;
+    do {
+      it->position += 32;
+      c = p->name[0];
+      if (c == SDMINFAT::DIR_NAME_FREE) {
+        it->end = 1;
+        return 0;
+      }
 
-    /* force write of entry to SD */
-    volume_writeCache();
+      /* Skip deleted and dot entries, long file names and the volume label, filter by extension */
+      if ((c != SDMINFAT::DIR_NAME_DELETED) && (c != '.') && !(p->attributes & SDMINFAT::DIR_ATT_VOLUME_ID) &&
+          (!it->ext || !memcmp(p->name + 8, it->ext, 3))) {
+        memcpy(info->name, p->name, 11);
+        info->attributes = p->attributes;
+        info->size = p->fileSize;
+        info->firstCluster = p->firstCluster();
+        info->entry.block = block;
+        info->entry.index = index;
+        return 1;
+      }
+      p++;
+    } while (++index < 16);
+  }
+  it->end = 1;
+  return 0;
+}
 
-  } /* Entry creation end */
+uint8_t file_open_entry(uint8_t mode) {
+  SDMINFAT::dir_t* p = file_readCacheDir();
 
   /* write to a read-only file is an error */
   if (mode && p->isReadOnly()) return 0;
@@ -586,6 +1501,8 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
   file_size = p->fileSize;
   file_isroot16dir = 0;
   file_position = 0;
+  file_extentCount = 0;
+  if (file_curCluster) file_extentAdd(0, file_curCluster);
 
   /* Writing to a non-empty file requires the file to be wiped first */
   if (file_size && (mode & SDMIN_FILE_WIPE)) {
@@ -596,70 +1513,251 @@ uint8_t file_open(const char* filename, const char* ext, uint8_t mode) {
 }
 
 void file_truncate() {
-  /* Delete contents of file */
   uint32_t next;
   uint32_t firstClst = file_curCluster;
+
+  /* Update file entry to show as empty first, so it never refers to freed clusters */
+  SDMINFAT::dir_t* p = file_readCacheDir();
+  p->fileSize = 0;
+  p->setFirstCluster(0);
+  volume_writeCache();
+
+  /* Delete contents of file */
   while (volume_fatGet(firstClst, &next)) {
     volume_fatPut(firstClst, 0);
     firstClst = next;
   }
   file_curCluster = 0;
+  file_allocLast = 0;
+  file_extentCount = 0;
   file_size = 0;
-  
-  /* Update file entry to show as empty to prevent corrupted state */
-  SDMINFAT::dir_t* p = file_readCacheDir();
-  p->fileSize = 0;
-  p->setFirstCluster(0);
-  volume_writeCache();
+  volume_flushCache();
+  volume_commitFAT();
 }
 
-/* Caches the block at the current position in the file
- * writeCluster indicates whether a new cluster can be appended */
-uint8_t* volume_cacheCurrentBlock(uint8_t writeCluster) {
+/*
+ * Reserves a contiguous run of clusters to write the bytes specified to, in a single pass over the FAT
+ * While writing or reading the reserved clusters the FAT is not accessed to find the next cluster
+ */
+uint8_t file_preallocate(uint32_t length) {
+  uint32_t clusterSize = (uint32_t) volume.blocksPerCluster << 9;
+  uint32_t used = file_position & (clusterSize - 1);
+  uint32_t count, cluster, linkClst;
+  uint32_t runStart = 0;
+  uint32_t runLength = 0;
+
+  /* Only possible at the end of a file with no reservation pending */
+  if (file_allocLast || file_isroot16dir || file_position != file_size) return 0;
+  if (!file_position && file_curCluster) return 0;
+
+  /* Space left in the current cluster does not have to be reserved */
+  if (used) {
+    if (length <= (clusterSize - used)) return 1;
+    length -= (clusterSize - used);
+  }
+  count = (length + clusterSize - 1) / clusterSize;
+  if (!count) return 1;
+
+  /* Find the first run of enough free clusters, starting at the free cluster hint */
+  for (cluster = volume.freeClusterHint; cluster <= volume.clusterLast; cluster++) {
+    if (!volume_fatGet(cluster, &linkClst)) return 0;
+    if (linkClst) {
+      runLength = 0;
+    } else {
+      if (!runLength) runStart = cluster;
+      if (++runLength == count) break;
+    }
+  }
+  if (runLength != count) return 0;
+
+  /* Link the clusters into a chain, all of which are likely in the same FAT block */
+  for (cluster = runStart; cluster != runStart + count - 1; cluster++) {
+    volume_fatPut(cluster, cluster + 1);
+  }
+  volume_fatPut(cluster, 0x0FFFFFFF);
+  if (runStart == volume.freeClusterHint) {
+    volume.freeClusterHint = cluster + 1;
+  }
+
+  if (file_curCluster == 0) {
+    /* first cluster; write the FAT out first, then the information to file dir block */
+    volume_flushCache();
+    SDMINFAT::dir_t* p = file_readCacheDir();
+    p->setFirstCluster(runStart);
+    volume_writeCache();
+  } else {
+    /* connect chains */
+    volume_fatPut(file_curCluster, runStart);
+  }
+
+  file_allocPrev = file_curCluster;
+  file_allocIndex = (file_position + clusterSize - 1) / clusterSize;
+  file_allocStart = runStart;
+  file_allocLast = cluster;
+  return volume.isInitialized;
+}
+
+/*
+ * Frees the clusters reserved using file_preallocate() that hold no file data,
+ * ending the cluster chain at the last cluster in use by the file
+ */
+static void file_releaseReserved(void) {
+  uint32_t clusterSize = (uint32_t) volume.blocksPerCluster << 9;
+  uint32_t used = (file_size + clusterSize - 1) / clusterSize;
+  uint32_t lastUsed, first, cluster;
+  if (!file_allocLast) return;
+
+  /* Find the last cluster holding data, which can be before the reserved clusters */
+  if (used > file_allocIndex) {
+    lastUsed = file_allocStart + (used - file_allocIndex) - 1;
+    if (lastUsed >= file_allocLast) {
+      file_allocLast = 0;
+      return;
+    }
+  } else {
+    lastUsed = file_allocPrev;
+  }
+
+  if (lastUsed) {
+    volume_fatPut(lastUsed, 0x0FFFFFFF);
+  } else {
+    /* No data was written at all, the directory entry must not refer to the clusters */
+    SDMINFAT::dir_t* p = file_readCacheDir();
+    p->setFirstCluster(0);
+    volume_writeCache();
+  }
+
+  /* Free the remainder of the reserved clusters */
+  first = (lastUsed >= file_allocStart && lastUsed < file_allocLast) ? (lastUsed + 1) : file_allocStart;
+  for (cluster = first; cluster <= file_allocLast; cluster++) {
+    volume_fatPut(cluster, 0);
+  }
+  if (file_curCluster >= first && file_curCluster <= file_allocLast) {
+    file_curCluster = lastUsed;
+  }
+  file_allocLast = 0;
+}
+
+/*
+ * Moves to a new position in the file. The current cluster is set to the cluster
+ * holding the byte before the position, the next cluster is moved to once it is read
+ */
+uint8_t file_seek(uint32_t position) {
+  uint32_t index, walkIndex, cluster;
+  FileExtent* e = file_extents;
+  uint8_t i;
+
+  if (position > file_size || file_isroot16dir) return 0;
+
+  /* Reserved clusters are only walked through from the end of the file */
+  file_releaseReserved();
+  if (!position) {
+    file_curCluster = file_extentCount ? file_extents[0].cluster : 0;
+    file_position = 0;
+    return 1;
+  }
+  if (!file_extentCount) return 0;
+
+  /* Look up the cluster in the runs known */
+  index = ((position - 1) >> 9) / volume.blocksPerCluster;
+  for (i = 0; i < file_extentCount; i++, e++) {
+    if (index < (e->index + e->count)) {
+      cluster = e->cluster + (index - e->index);
+      goto found;
+    }
+  }
+
+  /* Walk the FAT from the end of the last run, adding the clusters found */
+  e--;
+  walkIndex = e->index + e->count - 1;
+  cluster = e->cluster + e->count - 1;
+  while (walkIndex < index) {
+    cluster = volume_fatNext(cluster);
+    if (!cluster) return 0;
+    file_extentAdd(++walkIndex, cluster);
+  }
+
+found:
+  file_curCluster = cluster;
+  file_position = position;
+  return volume.isInitialized;
+}
+
+/* Gets the block at the current position in the file, moving to the next cluster if needed
+ * writeCluster indicates whether a new cluster can be appended
+ * Returns 0 on failure */
+static uint32_t file_currentBlock(uint8_t writeCluster) {
   uint16_t offset = (file_position & 0X1FF);
   uint32_t block = (file_position >> 9) & (volume.blocksPerCluster - 1);
   if (file_isroot16dir) {
     block += volume.rootCluster;
   } else {
     if (offset == 0 && block == 0) {
-      if (writeCluster) {
-        /* Add a new cluster (was file_addCluster()) */
+      uint32_t prevCluster = file_curCluster;
+
+      /* Past the last reserved cluster, continue the normal way */
+      if (file_allocLast == file_curCluster) {
+        file_allocLast = 0;
+      }
+      if (file_allocLast) {
+        /* Move on to the next reserved cluster without accessing the FAT */
+        if (file_curCluster >= file_allocStart && file_curCluster < file_allocLast) {
+          file_curCluster++;
+        } else {
+          file_curCluster = file_allocStart;
+        }
+      } else if (writeCluster && (file_position ? !volume_fatNext(file_curCluster) : !file_curCluster)) {
+        /*
+         * Add a new cluster (was file_addCluster()) when the file has no clusters yet,
+         * or the end of the chain is reached. At the start of a file that already has
+         * clusters, such as after file_seek(0), the first cluster is overwritten.
+         */
 
         uint32_t cluster; /* Free cluster found */
+        uint32_t start;   /* Cluster the search started at */
 
         /*
-         * Start looking from the current cluster
-         * Note: curCluster can be 0 (<2), we rely on fatGet to return nonzero here
+         * Start looking right after the current cluster to keep the file contiguous,
+         * but skip the clusters before the free cluster hint as those are in use
          */
-        cluster = file_curCluster;
+        cluster = file_curCluster + 1;
+        if (cluster < volume.freeClusterHint) cluster = volume.freeClusterHint;
+        if (cluster > volume.clusterLast) cluster = 2;
+        start = cluster;
 
         /* search the FAT for one free cluster */
         uint32_t linkClst;
         for (;;) {
-          /* Reached (the other way) around the start? Fail! */
-          if (++cluster == file_curCluster) {
-            volume.isInitialized = 0;
-            goto eof;
+          /* Read the next cluster of this cluster, if 0 it is free */
+          volume_fatGet(cluster, &linkClst);
+          if (linkClst == 0) {
+            /* Free, break and use this cluster */
+            break;
           }
 
           /* Past end - start from beginning of FAT */
-          if (cluster > volume.clusterLast) {
+          if (++cluster > volume.clusterLast) {
             cluster = 2;
           }
 
-          /* Read the next cluster of this cluster, if 0 it is free */
-          volume_fatGet(cluster, &linkClst);
-          if (linkClst == 0) {
-            /* Free, break and use this cluster */
-            break;
+          /* Reached (the other way) around the start? Fail! */
+          if (cluster == start) {
+            volume.isInitialized = 0;
+            return 0;
           }
         }
 
+        /* All clusters from the hint up till this one are in use */
+        if (start == volume.freeClusterHint && cluster >= start) {
+          volume.freeClusterHint = cluster + 1;
+        }
+
         /* mark found cluster end of chain */
         volume_fatPut(cluster, 0x0FFFFFFF);
 
         if (file_curCluster == 0) {
-          /* first cluster; write information to file dir block */
+          /* first cluster; write the FAT out first, then the information to file dir block */
+          volume_flushCache();
           SDMINFAT::dir_t* p = file_readCacheDir();
           p->setFirstCluster(cluster);
           volume_writeCache();
@@ -671,23 +1769,36 @@ uint8_t* volume_cacheCurrentBlock(uint8_t writeCluster) {
         /* update the current cluster to the last added one */
         file_curCluster = cluster;
       } else if (file_position > 0) {
-        /* get next cluster from FAT */
+        /* get next cluster from FAT, also when overwriting clusters already in the chain */
         volume_fatGet(file_curCluster, &file_curCluster);
       }
+
+      /* Remember the cluster runs walked through for seeking */
+      if (file_curCluster != prevCluster) {
+        file_extentAdd((file_position >> 9) / volume.blocksPerCluster, file_curCluster);
+      }
     }
 
     /* Add the block index of the start of the current cluster */
     block += volume_firstClusterBlock(file_curCluster);
   }
-  if (writeCluster) {
-    /* Flush anything in the buffer right now; proceed to write */
-    volume_updateCache(block);
-  } else {
-    /* Read in the new block */
-    volume_readCache(block);
+  return block;
+}
+
+/* Caches the block at the current position in the file
+ * writeCluster indicates whether a new cluster can be appended */
+uint8_t* volume_cacheCurrentBlock(uint8_t writeCluster) {
+  uint32_t block = file_currentBlock(writeCluster);
+  if (block) {
+    if (writeCluster) {
+      /* Flush anything in the buffer right now; proceed to write */
+      volume_updateCache(block);
+    } else {
+      /* Read in the new block */
+      volume_readCache(block);
+    }
   }
-eof:
-  return volume_cacheBuffer.data + offset;
+  return volume_cacheBuffer.data + (file_position & 0X1FF);
 }
 
 /* 
@@ -739,6 +1850,73 @@ char file_read_byte(void) {
   return *file_read(1);
 }
 
+/* Writes a byte to the LCD data port, toggling the write pin to latch it */
+#define lcdWrite(b)  TFTLCD_WR_PORT = wr_a; TFTLCD_DATA_PORT = b; TFTLCD_WR_PORT = wr_b;
+
+/*
+ * Reads 16-bit pixels from the file and writes them straight to the LCD data port.
+ * Pixels are stored low byte first, the LCD expects the high byte first.
+ * Full blocks that are not cached are not copied into the cache; instead every
+ * pixel is written to the LCD while the next byte is received over SPI.
+ * The LCD must be set up to receive pixel data before calling this function.
+ */
+void file_read_lcd(uint32_t pixelCount) {
+  /* Preserve the other pins on the LCD control port, SRAM chip-select among them */
+  uint8_t wr_b = TFTLCD_WR_PORT | TFTLCD_WR_MASK;
+  uint8_t wr_a = wr_b & ~TFTLCD_WR_MASK;
+  uint8_t low, high, next;
+  uint8_t* data;
+  uint8_t count;
+  uint32_t block;
+
+  while (pixelCount && volume.isInitialized) {
+    /* Partial blocks at the start or end are read through the cache */
+    if ((file_position & 0x1FF) || pixelCount < 256) {
+      low = file_read_byte();
+      high = file_read_byte();
+      lcdWrite(high);
+      lcdWrite(low);
+      pixelCount--;
+      continue;
+    }
+
+    block = file_currentBlock(0);
+    if (!block) break;
+    count = 0; /* 256 pixels */
+    if (block == volume_cacheBlockNumber) {
+      /* Block is already cached (and may be modified), write it from there */
+      data = volume_cacheBuffer.data;
+      do {
+        lcdWrite(data[1]);
+        lcdWrite(data[0]);
+        data += 2;
+      } while (--count);
+    } else {
+      if (!card_readBegin(block)) break;
+
+      /* Receive the first pixel */
+      low = spiRec();
+      high = spiRec();
+
+      /* Write out each byte while receiving the next, the last two bytes received are the CRC */
+      do {
+        SPDR = 0xFF;
+        lcdWrite(high);
+        spiWait();
+        next = SPDR;
+        SPDR = 0xFF;
+        lcdWrite(low);
+        low = next;
+        spiWait();
+        high = SPDR;
+      } while (--count);
+      if (card_streamMode == CARD_STREAM_READ) card_streamBlock = block + 1;
+    }
+    file_position += 512;
+    pixelCount -= 256;
+  }
+}
+
 /* 
  * Writes a single byte to the file. Taken over from the original buffer writing,
  * optimized to write single bytes at a time only
@@ -57,13 +57,45 @@ THE SOFTWARE.
 #include "PHNCore.h"
 
 #define SDMIN_FILE_READ    0
-#define SDMIN_FILE_WRITE   (FILE_CREATE | FILE_WIPE)
+#define SDMIN_FILE_WRITE   (SDMIN_FILE_CREATE | SDMIN_FILE_WIPE)
 #define SDMIN_FILE_CREATE  1
 #define SDMIN_FILE_WIPE    2
 
+/* Multi-block streaming modes of the card */
+#define CARD_STREAM_NONE   0
+#define CARD_STREAM_READ   1
+#define CARD_STREAM_WRITE  2
+
+/* Amount of contiguous cluster runs of the opened file remembered for seeking */
+#define FILE_EXTENT_COUNT  4
+
+/* Amount of subdirectories remembered by file_open_path() to avoid scanning their parents again */
+#define DIR_CACHE_COUNT    4
+
+/* 
+ * Amount of blocks that can be cached, including the main cache buffer.
+ * Additional slots keep FAT blocks cached while file data is read or written,
+ * so FAT changes are written out once instead of for every cluster. They are
+ * written out before a directory block is, so directory entries never refer
+ * to clusters that are not linked on the card yet.
+ * Every additional slot costs 519 bytes of RAM, so this defaults to 1 (no additional
+ * slots) to keep the library minimal. Set to 2 or more for faster writing of large files.
+ */
+#define VOLUME_CACHE_SLOTS 1
+
+/*
+ * Amount of FAT and directory blocks kept in external SRAM by the second-level cache.
+ * Each block uses 512 bytes of SRAM and 5 bytes of RAM, at most 48 blocks can be used.
+ * Set to 0 to leave out the second-level cache, otherwise enable it using volume_enableL2().
+ */
+#define VOLUME_L2_BLOCKS 0
+
 /* SCK Speed defines */
-/* Speed number, 0 is full speed, 6 is slowest speed */
-#define SCK_SPEED 1
+/* 
+ * Fastest speed number used, 0 is full speed, 6 is slowest speed
+ * The speed actually used is negotiated with the card during initialization
+ */
+#define SCK_SPEED 0
 
 /* ============================================================================== */
 
@@ -73,6 +105,31 @@ typedef struct {
   uint8_t index;
 } FilePtr;
 
+/// Stores a run of contiguous clusters of a file
+typedef struct {
+  uint32_t index;    /* index of the first cluster of the run in the file */
+  uint32_t cluster;  /* first cluster of the run */
+  uint32_t count;    /* amount of clusters in the run */
+} FileExtent;
+
+/// Stores the state of a directory iteration, can be stored to continue iterating later
+typedef struct {
+  uint32_t cluster;   /* cluster of the current position, unused for the FAT16 root directory */
+  uint32_t position;  /* byte position of the next entry in the directory */
+  const char* ext;    /* 3-character extension entries must have, NULL for all entries */
+  uint8_t isroot16;   /* directory is a FAT16 root directory */
+  uint8_t end;        /* end of the directory was reached */
+} DirIterator;
+
+/// Stores the information of a directory entry found while iterating a directory
+typedef struct {
+  char name[11];          /* 8.3 format name, name and extension padded with spaces */
+  uint8_t attributes;     /* entry attributes, see SDMINFAT::DIR_ATT_ */
+  uint32_t size;          /* size of the file in bytes */
+  uint32_t firstCluster;  /* first cluster of the file or directory */
+  FilePtr entry;          /* location of the directory entry, can be opened using file_open_entry() */
+} DirEntryInfo;
+
 /// Stores all arguments to complete a full card command, order matters!
 typedef struct {
   uint8_t crc;
@@ -81,6 +138,19 @@ typedef struct {
   uint32_t flush;
 } CardCommand;
 
+/// Stores the transfer statistics of the card, for diagnostics
+typedef struct {
+  uint32_t readCount;     /* amount of blocks read */
+  uint32_t readMicros;    /* total time waiting for the card to start sending block data */
+  uint32_t writeCount;    /* amount of blocks written */
+  uint32_t writeMicros;   /* total time writing blocks, including programming */
+  uint16_t errors;        /* amount of failed transfers and speed verifications */
+#if VOLUME_L2_BLOCKS
+  uint32_t l2Hits;        /* amount of FAT and directory blocks read from the second-level cache */
+  uint32_t l2Misses;      /* amount of FAT and directory blocks that had to be read from the card */
+#endif
+} CardStats;
+
 /// Stores all information about a loaded volume
 typedef struct {
   uint8_t isInitialized;     /* Indicates whether the volume is successfully initialized. Reset when errors occur */
@@ -93,11 +163,20 @@ typedef struct {
   uint32_t rootSize;         /* Total size of a FAT16 root directory */
   uint32_t dataStartBlock;   /* first data block number */
   uint32_t fatStartBlock;    /* start block for first FAT */
+  uint32_t fsInfoBlock;      /* FAT32 FSInfo block storing the hints below, 0 if not available */
+  uint32_t freeClusterHint;  /* cluster to start looking for free clusters, clusters before it are in use */
+  uint32_t freeClusterCount; /* amount of free clusters, FSINFO_UNKNOWN if unknown */
+  uint8_t fsInfoChanged;     /* the hints changed since the FSInfo block was last written */
 } CardVolume;
 
 /* ============================================================================== */
 
 extern uint8_t card_notSDHCBlockShift;      /* Card is SD1 or SD2, and NOT SDHC. In that case this value is 9, 0 otherwise */
+extern uint8_t card_streamEnabled;          /* Sequential data blocks are transferred using multi-block commands */
+extern uint8_t card_streamMode;             /* Multi-block transfer currently in progress, CARD_STREAM_NONE if none */
+extern uint32_t card_streamBlock;           /* Next block number of the multi-block transfer in progress */
+extern uint8_t card_speed;                  /* SPI speed number negotiated with the card, 0 is full speed, 6 is slowest speed */
+extern CardStats card_stats;                /* transfer statistics since the last card_resetStats() */
 
 extern union SDMINFAT::cache_t volume_cacheBuffer;  /* 512 byte cache for device blocks */
 extern uint32_t volume_cacheBlockNumber;   /* Logical number of block in the cache */
@@ -105,12 +184,17 @@ extern uint8_t  volume_cacheDirty;         /* readCache() will write current blo
 extern uint8_t  volume_cacheFATMirror;     /* current block in cache is a mirrored FAT block */
 
 extern CardVolume volume;                  /* stores all current volume information */
+extern uint16_t volume_dirVersion;         /* Incremented every time entries are added, renamed or removed */
 
 extern uint8_t   file_isroot16dir;         /* file is a FAT16 root directory */
 extern uint32_t  file_curCluster;          /* cluster for current file position */
 extern uint32_t  file_position;            /* current file position in bytes from beginning */
 extern FilePtr   file_curDir;              /* directory currently selected */
 extern uint32_t  file_size;                /* total size of the currently opened file */
+extern uint32_t  file_allocStart;          /* first cluster reserved using file_preallocate() */
+extern uint32_t  file_allocLast;           /* last cluster reserved using file_preallocate(), 0 if none */
+extern FileExtent file_extents[FILE_EXTENT_COUNT]; /* cluster runs of the file from the start, collected while walking */
+extern uint8_t   file_extentCount;         /* amount of cluster runs stored in file_extents */
 
 /* ============================================================================== */
 
@@ -120,11 +204,82 @@ uint8_t card_command(uint8_t cmd, uint32_t arg, uint8_t crc);
 uint8_t card_waitForData(uint8_t data_state);
 /// Turns the card chip-select on or off
 void card_setEnabled(uint8_t enabled);
+/// Stops a multi-block read or write transfer in progress, if any
+void card_streamStop(void);
+/// Resets the transfer statistics of the card
+void card_resetStats(void);
+/// Gets the average time in microseconds before the card starts sending a block that is read
+inline uint32_t card_readLatency(void) {
+  return card_stats.readCount ? (card_stats.readMicros / card_stats.readCount) : 0;
+}
+/// Gets the average time in microseconds needed to write a block
+inline uint32_t card_writeLatency(void) {
+  return card_stats.writeCount ? (card_stats.writeMicros / card_stats.writeCount) : 0;
+}
+/**
+ * @brief Enables or disables multi-block streaming of sequential data blocks
+ *
+ * When enabled, reading or writing data blocks one after the other uses a single
+ * multi-block command (CMD18/CMD25) for the whole contiguous run, instead of a
+ * command per block. Fragmented files fall back to single-block commands.
+ * While a transfer is in progress the card owns the SPI bus, so disable streaming
+ * or call card_setEnabled(0) before communicating with other SPI devices.
+ */
+void volume_setStreaming(uint8_t enabled);
+/**
+ * @brief Enables or disables atomic updates, protecting the volume against power loss
+ *
+ * File data and FAT changes are always written out before the directory entry refers
+ * to them, and directory entries are emptied before clusters are freed. In atomic mode
+ * the mirror FAT is additionally left untouched until the directory entry is written
+ * by file_flush(), file_save() or file_truncate(), and the FAT is marked as not clean
+ * while that is pending. Enable before the volume is initialized: volume_init() then
+ * copies the FAT to the mirror FAT when the previous update did not complete.
+ */
+void volume_setAtomic(uint8_t enabled);
+#if VOLUME_L2_BLOCKS
+/**
+ * @brief Enables the second-level cache of FAT and directory blocks in external SRAM
+ *
+ * FAT blocks, the FAT16 root directory and directory blocks read while scanning or
+ * opening entries are kept in an SRAM arena named "SDL2", so walking cluster chains and
+ * scanning directories again does not wait for the card. Writes update the cached copy
+ * before the card, keeping it identical to the card. The chip-select of the card is
+ * switched around every SRAM transfer, ending any multi-block transfer in progress.
+ * sram.begin() must have succeeded first. Returns 0 if no SRAM could be reserved.
+ */
+uint8_t volume_enableL2(void);
+/// Disables the second-level cache, the SRAM arena stays reserved
+void volume_disableL2(void);
+/// Gets the percentage of FAT and directory block reads served by the second-level cache
+inline uint8_t volume_l2HitRatio(void) {
+  uint32_t total = card_stats.l2Hits + card_stats.l2Misses;
+  return total ? (uint8_t) ((card_stats.l2Hits * 100) / total) : 0;
+}
+#endif
+
+/**
+ * @brief Requests a block to be read, without waiting for the card to prepare the data
+ *
+ * While the card is busy the caller can do other work, such as drawing the data
+ * of the block still in the cache. The data is received into the cache using
+ * block_read_finish(), or by reading the same block using volume_readCache().
+ * Any other card command first receives and discards the requested block.
+ * Other SPI devices can not be used until the read is finished.
+ * Returns 0 if the read command failed.
+ */
+uint8_t block_read_begin(uint32_t blockNumber);
+/// Checks whether the card finished preparing the requested block, returns 1 if block_read_finish() will not wait
+uint8_t block_read_poll(void);
+/// Receives the block requested using block_read_begin() into the cache, returns the cache data or NULL on failure
+uint8_t* block_read_finish(void);
 
 /// Writes out the current cached block
 void volume_writeCache(void);
 /// Writes out the current cached block to the block specified
 void volume_writeCache(uint32_t block);
+/// Writes out the current cached block and all other cached blocks that were modified
+void volume_flushCache(void);
 /// Gets the first block of a cluster
 inline uint32_t volume_firstClusterBlock(uint32_t cluster) {
   return volume.dataStartBlock + ((cluster - 2) * volume.blocksPerCluster);
@@ -149,8 +304,60 @@ uint8_t volume_init(uint8_t resetPosition = 1);
  * and SDMIN_FILE_CREATE are possible
  */
 uint8_t file_open(const char* filename, const char* ext, uint8_t mode);
+/**
+ * @brief Initializes the card, then attempts to find and open the file at the path specified
+ *
+ * The path consists of directory names and the file name separated by slashes,
+ * for example "IMAGES/ICON01.LCD", relative to the root directory. Names are in the 8.3
+ * format and are converted to upper case. Directories resolved are remembered, so opening
+ * other files in the same directory does not scan the parent directories again.
+ * The directories must exist, the file is created if the mode specifies so.
+ */
+uint8_t file_open_path(const char* path, uint8_t mode);
+/// Opens the file of the directory entry file_curDir points to, using the mode specified
+uint8_t file_open_entry(uint8_t mode);
+/**
+ * @brief Starts iterating the entries of a directory
+ *
+ * The directory is specified by its first cluster, 0 for the root directory.
+ * Only entries with the 3-character extension specified are iterated, NULL for all.
+ * The extension string must remain valid while iterating. The volume must be initialized.
+ */
+void dir_iterator_begin(DirIterator* it, uint32_t dirCluster, const char* ext);
+/**
+ * @brief Reads the next entry of a directory being iterated
+ *
+ * Deleted entries, long file name entries, the volume label and the dot entries are skipped.
+ * Each directory block is read once for all the entries in it. Iterating does not change
+ * the currently opened file, allowing files to be opened in between.
+ * Returns 1 if an entry was read, 0 when the end of the directory was reached.
+ */
+uint8_t dir_iterator_next(DirIterator* it, DirEntryInfo* info);
 /// Deletes all contents of a file (must call after opening file)
 void file_truncate();
+/**
+ * @brief Reserves a contiguous run of clusters for writing the amount of bytes specified
+ *
+ * Must be called at the end of the file, typically right after opening it for writing.
+ * The clusters are linked to the file in a single pass over the FAT, after which
+ * writing (or reading) them back does not access the FAT anymore. Combined with
+ * multi-block streaming this allows for high and steady write rates. Clusters that
+ * hold no data when the file is flushed, saved or seeked are freed again, so the
+ * cluster chain never extends past the size stored in the directory entry.
+ * Returns whether the clusters could be reserved.
+ */
+uint8_t file_preallocate(uint32_t length);
+/**
+ * @brief Moves the position in the currently opened file
+ *
+ * The cluster at the position is looked up in the cluster runs collected while
+ * walking the file earlier, so seeking within the part of the file that was
+ * already read or written does not access the FAT. Seeking further walks the
+ * FAT from the end of the last run known. Seeking ends a reservation made
+ * using file_preallocate(), the reserved clusters past the end of the file are freed.
+ * Returns whether the position could be set, it can not exceed the file size.
+ */
+uint8_t file_seek(uint32_t position);
 /// Flushes any pending block writes to the card
 void file_flush(void);
 /// Reads the current directory entry information into the cache
@@ -165,6 +372,14 @@ char* file_read(uint16_t nByteIncrement);
 void file_write(const char* data, uint16_t nBytes);
 /// Reads a single byte
 char file_read_byte(void);
+/**
+ * @brief Reads 16-bit pixels and writes them directly to the LCD
+ *
+ * Pixels are stored low byte first, as in the .LCD image format. Full blocks are
+ * transferred from SPI to the LCD data port without passing through the cache.
+ * The LCD must be set up to receive pixel data (viewport and cursor) beforehand.
+ */
+void file_read_lcd(uint32_t pixelCount);
 /// Writes a single byte
 void file_write_byte(char b);
 /// Writes a single byte at the end of the file
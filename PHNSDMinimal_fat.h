@@ -308,10 +308,47 @@ uint32_t const FAT32EOC = 0X0FFFFFFF;
 uint32_t const FAT32EOC_MIN = 0X0FFFFFF8;
 /** Mask a for FAT32 entry. Entries are 28 bits. */
 uint32_t const FAT32MASK = 0X0FFFFFFF;
+/** Bit of the second FAT16 entry that is set when the volume is consistent (clean shutdown) */
+uint16_t const FAT16_CLEAN_SHUTDOWN = 0X8000;
+/** Bit of the second FAT32 entry that is set when the volume is consistent (clean shutdown) */
+uint32_t const FAT32_CLEAN_SHUTDOWN = 0X08000000;
 
 /** Type name for fat32BootSector */
 typedef struct fat32BootSector fbs_t;
 
+/** Lead signature of a FAT32 FSInfo sector */
+uint32_t const FSINFO_LEAD_SIG = 0X41615252;
+/** Struct signature of a FAT32 FSInfo sector */
+uint32_t const FSINFO_STRUCT_SIG = 0X61417272;
+/** Free count or next free value of a FAT32 FSInfo sector that is unknown */
+uint32_t const FSINFO_UNKNOWN = 0XFFFFFFFF;
+
+/**
+ * \struct fat32FSInfo
+ *
+ * \brief FSInfo sector for a FAT32 volume, storing allocation hints.
+ *
+ */
+struct fat32FSInfo {
+           /** must be 0X41615252 */
+  uint32_t leadSignature;
+           /** must be zero */
+  uint8_t  reserved1[480];
+           /** must be 0X61417272 */
+  uint32_t structSignature;
+           /** last known free cluster count, 0XFFFFFFFF if unknown */
+  uint32_t freeCount;
+           /** cluster to start looking for free clusters, 0XFFFFFFFF if unknown */
+  uint32_t nextFree;
+           /** must be zero */
+  uint8_t  reserved2[12];
+           /** must be 0XAA550000 */
+  uint32_t tailSignature;
+};
+
+/** Type name for fat32FSInfo */
+typedef struct fat32FSInfo fsinfo_t;
+
 /** name[0] value for entry that is free after being "deleted" */
 uint8_t const DIR_NAME_DELETED = 0XE5;
 /** name[0] value for entry that is free and no allocated entries follow */
@@ -434,6 +471,7 @@ union cache_t {
   dir_t    dir[16];    /* Used to access cached directory entries. */
   mbr_t    mbr;        /* Used to access a cached MasterBoot Record. */
   fbs_t    fbs;        /* Used to access to a cached FAT boot sector. */
+  fsinfo_t fsinfo;     /* Used to access a cached FAT32 FSInfo sector. */
 };
 
 /* 
@@ -458,10 +496,14 @@ uint8_t const CMD8 = 0X08;
 uint8_t const CMD9 = 0X09;
 /** SEND_CID - read the card identification information (CID register) */
 uint8_t const CMD10 = 0X0A;
+/** STOP_TRANSMISSION - end multiple block read sequence */
+uint8_t const CMD12 = 0X0C;
 /** SEND_STATUS - read the card status register */
 uint8_t const CMD13 = 0X0D;
 /** READ_BLOCK - read a single data block from the card */
 uint8_t const CMD17 = 0X11;
+/** READ_MULTIPLE_BLOCK - read multiple data blocks from the card */
+uint8_t const CMD18 = 0X12;
 /** WRITE_BLOCK - write a single data block to the card */
 uint8_t const CMD24 = 0X18;
 /** WRITE_MULTIPLE_BLOCK - write blocks of data until a STOP_TRANSMISSION */
@@ -477,6 +519,8 @@ uint8_t const CMD38 = 0X26;
 uint8_t const CMD55 = 0X37;
 /** READ_OCR - read the OCR register of a card */
 uint8_t const CMD58 = 0X3A;
+/** CRC_ON_OFF - turn CRC checking of commands and data on (1) or off (0) */
+uint8_t const CMD59 = 0X3B;
 /** SET_WR_BLK_ERASE_COUNT - Set the number of write blocks to be
      pre-erased before writing */
 uint8_t const ACMD23 = 0X17;
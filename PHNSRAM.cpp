@@ -28,13 +28,20 @@ THE SOFTWARE.
 /* Global instance */
 PHN_SRAM sram;
 
+/* SPI clock settings in use by other devices, restored after accessing the SRAM */
+static uint8_t sram_spcr, sram_spsr;
+
 /* 
  * Macros to enable, disable or use the SRAM chip functions
  * When enabling, a WAKE is performed by rapidly toggling the hold pin
+ * The SRAM is accessed at full speed (f_osc/2), other devices may use a slower clock
  */
 #define SRAM_EN()       EXSRAM_HOLD_PORT &= ~EXSRAM_HOLD_MASK;
-#define SRAM_Disable()  EXSRAM_HOLD_PORT |= EXSRAM_HOLD_MASK;
-#define SRAM_Enable()   SRAM_EN(); SRAM_Disable(); SRAM_EN();
+#define SRAM_Hold()     EXSRAM_HOLD_PORT |= EXSRAM_HOLD_MASK;
+#define SRAM_Enable()   SRAM_EN(); SRAM_Hold(); SRAM_EN(); \
+                        sram_spcr = SPCR; sram_spsr = SPSR; \
+                        SPCR = sram_spcr & ~((1 << SPR1) | (1 << SPR0)); SPSR = (1 << SPI2X);
+#define SRAM_Disable()  SRAM_Hold(); SPCR = sram_spcr; SPSR = sram_spsr;
 #define SRAM_Wait()     while (!(SPSR & (1 << SPIF)));
 #define SRAM_Send(b)    SPDR = b; SRAM_Wait();
 
@@ -54,6 +61,9 @@ uint8_t PHN_SRAM::begin() {
   // Set External RAM HOLD pin to output
   EXSRAM_HOLD_DDR |= EXSRAM_HOLD_MASK;
 
+  // Contents of the chip are unknown, drop the cached page
+  _pageAddress = SRAM_NULL;
+
   // Set up status register to sequential mode
   // Both single-byte and block write functions use sequential mode
   // Page mode is never used and appears to be pointless
@@ -78,32 +88,94 @@ uint8_t PHN_SRAM::begin() {
   return success;
 }
 
+/*
+ * The transfer loops below keep the SPI bus busy: the next byte to send is loaded
+ * and the previous byte received is stored while the current byte is transferred.
+ * At f_osc/2 a byte takes 16 cycles, so little more than the transfer itself remains.
+ */
 void PHN_SRAM::readBlock(uint16_t address, char* data, uint16_t length) {
+  /* Small reads within a single page are served from the page cache */
+  address &= (SRAM_CAPACITY - 1);
+  uint16_t page = address & ~(SRAM_PAGE_SIZE - 1);
+  if (length && length <= SRAM_PAGE_SIZE && ((address + length - 1) & ~(SRAM_PAGE_SIZE - 1)) == page) {
+    if (page != _pageAddress) {
+      readDirect(page, _page, SRAM_PAGE_SIZE);
+      _pageAddress = page;
+    }
+    memcpy(data, _page + (address - page), length);
+  } else {
+    readDirect(address, data, length);
+  }
+}
+
+void PHN_SRAM::readDirect(uint16_t address, char* data, uint16_t length) {
+  if (!length) return;
   SRAM_Enable();
   setAddress(SRAM_CMD_DATA_READ, address);
-  data--;
-  while (length) {
-    SPDR = 0xFF;
-    data++;
-    length--;
+  SPDR = 0xFF;
+  while (--length) {
     SRAM_Wait();
-    *data = SPDR;
+    char b = SPDR;
+    SPDR = 0xFF;
+    *(data++) = b;
   }
+  SRAM_Wait();
+  *data = SPDR;
   SRAM_Disable();
 }
 
 void PHN_SRAM::writeBlock(uint16_t address, const char* data, uint16_t length) {
+  if (!length) return;
+  updatePage(address, data, 0, length);
+  SRAM_Enable();
+  setAddress(SRAM_CMD_DATA_WRITE, address);
+  SPDR = *(data++);
+  while (--length) {
+    char b = *(data++);
+    SRAM_Wait();
+    SPDR = b;
+  }
+  SRAM_Wait();
+  SRAM_Disable();
+}
+
+void PHN_SRAM::fillBlock(uint16_t address, char dataByte, uint16_t length) {
+  if (!length) return;
+  updatePage(address, NULL, dataByte, length);
   SRAM_Enable();
   setAddress(SRAM_CMD_DATA_WRITE, address);
-  while (length) {
-    SPDR = *data;
-    data++;
-    length--;
+  SPDR = dataByte;
+  while (--length) {
     SRAM_Wait();
+    SPDR = dataByte;
   }
+  SRAM_Wait();
   SRAM_Disable();
 }
 
+void PHN_SRAM::moveBlock(uint16_t destAddress, uint16_t srcAddress, uint16_t length) {
+  // Copy in chunks, starting at the end when moving up so the source is not overwritten first
+  char buff[32];
+  uint16_t n;
+  if (destAddress > srcAddress) {
+    while (length) {
+      n = min(length, sizeof(buff));
+      length -= n;
+      readBlock(srcAddress + length, buff, n);
+      writeBlock(destAddress + length, buff, n);
+    }
+  } else if (destAddress < srcAddress) {
+    while (length) {
+      n = min(length, sizeof(buff));
+      readBlock(srcAddress, buff, n);
+      writeBlock(destAddress, buff, n);
+      srcAddress += n;
+      destAddress += n;
+      length -= n;
+    }
+  }
+}
+
 void PHN_SRAM::readSegment(uint16_t index, void* ptr, uint16_t segmentSize) {
   readBlock(index*segmentSize, (char*) ptr, segmentSize);
 }
@@ -119,16 +191,22 @@ uint8_t PHN_SRAM::writeBlockVerify(uint16_t address, const char* data, uint16_t
 
 uint8_t PHN_SRAM::verifyBlock(uint16_t address, const char* data, uint16_t length) {
   uint8_t success = 1;
+  if (!length) return success;
   SRAM_Enable();
   setAddress(SRAM_CMD_DATA_READ, address);
-  data--;
-  while (length && success) {
-    SPDR = 0xFF;
-    data++;
-    length--;
+  SPDR = 0xFF;
+  while (--length) {
+    char expected = *(data++);
     SRAM_Wait();
-    success &= (*data == (char) SPDR);
+    char b = SPDR;
+    SPDR = 0xFF;
+    if (b != expected) {
+      success = 0;
+      break;
+    }
   }
+  SRAM_Wait();
+  if (success) success = (*data == (char) SPDR);
   SRAM_Disable();
   return success;
 }
@@ -143,8 +221,146 @@ void PHN_SRAM::write(uint16_t address, char dataByte) {
   writeBlock(address, &dataByte, 1);
 }
 
+void PHN_SRAM::updatePage(uint16_t address, const char* data, char dataByte, uint16_t length) {
+  if (_pageAddress == SRAM_NULL) return;
+  address &= (SRAM_CAPACITY - 1);
+
+  /* Writes wrapping around the end of the chip simply drop the cached page */
+  if ((uint32_t) address + length > SRAM_CAPACITY) {
+    _pageAddress = SRAM_NULL;
+    return;
+  }
+
+  /* Copy the part of the data that overlaps with the cached page */
+  uint16_t start = max(address, _pageAddress);
+  uint16_t end = min((uint32_t) address + length, (uint32_t) _pageAddress + SRAM_PAGE_SIZE);
+  for (; start < end; start++) {
+    _page[start - _pageAddress] = data ? data[start - address] : dataByte;
+  }
+}
+
+uint16_t PHN_SRAM::readWord(uint16_t address) {
+  uint16_t value;
+  readBlock(address, (char*) &value, sizeof(value));
+  return value;
+}
+
+void PHN_SRAM::writeWord(uint16_t address, uint16_t value) {
+  writeBlock(address, (const char*) &value, sizeof(value));
+}
+
+uint8_t PHN_SRAM::findArena(const char* name) {
+  for (uint8_t i = 0; i < SRAM_ARENA_COUNT; i++) {
+    if (_arenas[i].type != SRAM_ARENA_UNUSED && !strncmp(_arenas[i].name, name, SRAM_ARENA_NAME)) {
+      return i;
+    }
+  }
+  return SRAM_ARENA_NONE;
+}
+
+uint8_t PHN_SRAM::createArena(const char* name, uint16_t size, uint8_t type) {
+  uint8_t i = findArena(name);
+  if (i != SRAM_ARENA_NONE) {
+    /* Already exists, make sure it can be used the same way */
+    SRAMArena &arena = _arenas[i];
+    return (arena.type == type && (arena.end - arena.start) >= size) ? i : SRAM_ARENA_NONE;
+  }
+
+  /* Keep arenas aligned to 2 bytes for the heap block headers */
+  size = (size + 1) & ~1;
+  if (size > available() || (type == SRAM_ARENA_HEAP && size < 4)) return SRAM_ARENA_NONE;
+
+  /* Find an unused arena slot and reserve the region following the last arena */
+  for (i = 0; i < SRAM_ARENA_COUNT; i++) {
+    SRAMArena &arena = _arenas[i];
+    if (arena.type == SRAM_ARENA_UNUSED) {
+      strncpy(arena.name, name, SRAM_ARENA_NAME);
+      arena.type = type;
+      arena.start = _arenaEnd;
+      arena.end = _arenaEnd + size;
+      _arenaEnd += size;
+      resetArena(i);
+      return i;
+    }
+  }
+  return SRAM_ARENA_NONE;
+}
+
+void PHN_SRAM::resetArena(uint8_t arena) {
+  if (arena >= SRAM_ARENA_COUNT) return;
+  SRAMArena &a = _arenas[arena];
+  a.top = a.start;
+
+  /* A heap starts out as a single free block spanning the entire arena */
+  if (a.type == SRAM_ARENA_HEAP) {
+    writeWord(a.start, a.end - a.start);
+  }
+}
+
+void PHN_SRAM::clearArenas() {
+  memset(_arenas, 0, sizeof(_arenas));
+  _arenaEnd = 0;
+}
+
+/*
+ * Heap arenas are a sequence of blocks, each starting with a 2-byte header storing
+ * the size of the block including the header. Bit 0 is set when the block is in use.
+ * Allocation takes the first free block large enough, merging free blocks following it.
+ */
+SRAMHandle PHN_SRAM::alloc(uint8_t arena, uint16_t size) {
+  if (arena >= SRAM_ARENA_COUNT) return SRAM_NULL;
+  SRAMArena &a = _arenas[arena];
+
+  if (a.type == SRAM_ARENA_BUMP) {
+    if (size > (a.end - a.top)) return SRAM_NULL;
+    SRAMHandle handle = a.top;
+    a.top += size;
+    return handle;
+  }
+  if (a.type != SRAM_ARENA_HEAP) return SRAM_NULL;
+
+  uint16_t needed = (size + 3) & ~1;
+  uint16_t addr = a.start;
+  uint16_t block, next;
+  while (addr < a.end) {
+    block = readWord(addr);
+    if (!(block & ~1)) return SRAM_NULL; /* corrupted */
+    if (!(block & 1)) {
+      /* Merge the free blocks that follow */
+      uint16_t merged = block;
+      while ((addr + merged) < a.end && !((next = readWord(addr + merged)) & 1)) {
+        merged += next;
+      }
+      if (merged >= needed) {
+        /* Split off the remainder if large enough for another block */
+        if ((merged - needed) >= 4) {
+          writeWord(addr + needed, merged - needed);
+          merged = needed;
+        }
+        writeWord(addr, merged | 1);
+        return addr + 2;
+      }
+      if (merged != block) writeWord(addr, merged);
+      block = merged;
+    }
+    addr += block & ~1;
+  }
+  return SRAM_NULL;
+}
+
+void PHN_SRAM::free(SRAMHandle handle) {
+  if (handle == SRAM_NULL) return;
+  writeWord(handle - 2, readWord(handle - 2) & ~1);
+}
+
 void PHN_SRAM::setAddress(uint8_t mode, uint16_t address) {
-  SRAM_Send(mode);
-  SRAM_Send((address >> 8) & 0xFF);
-  SRAM_Send(address & 0xFF);
+  /* Prepare the address bytes while the previous byte is transferred */
+  SPDR = mode;
+  uint8_t high = (address >> 8) & 0xFF;
+  uint8_t low = address & 0xFF;
+  SRAM_Wait();
+  SPDR = high;
+  SRAM_Wait();
+  SPDR = low;
+  SRAM_Wait();
 }
\ No newline at end of file
@@ -33,6 +33,37 @@ THE SOFTWARE.
 #include <Arduino.h>
 #include "PHNCore.h"
 
+/// Total amount of bytes stored by the SRAM chip
+#define SRAM_CAPACITY      32768
+/// Amount of bytes of the page cached in RAM, small reads within this page do not access the chip
+#define SRAM_PAGE_SIZE     16
+/// Maximum amount of arenas that can be created
+#define SRAM_ARENA_COUNT   6
+/// Maximum length of the name of an arena
+#define SRAM_ARENA_NAME    6
+
+/* Arena types */
+#define SRAM_ARENA_UNUSED  0
+#define SRAM_ARENA_BUMP    1
+#define SRAM_ARENA_HEAP    2
+
+/// Arena index returned when an arena could not be created or found
+#define SRAM_ARENA_NONE    0xFF
+/// Handle returned when memory could not be allocated
+#define SRAM_NULL          0xFFFF
+
+/// Handle to memory allocated in SRAM, which is the SRAM address of the memory
+typedef uint16_t SRAMHandle;
+
+/// Stores the region and allocation state of an arena
+typedef struct {
+  char name[SRAM_ARENA_NAME];  /* name of the arena, only null-terminated when shorter than the maximum */
+  uint8_t type;                /* SRAM_ARENA_BUMP or SRAM_ARENA_HEAP, SRAM_ARENA_UNUSED if unused */
+  uint16_t start;              /* first SRAM address of the arena */
+  uint16_t end;                /* SRAM address following the last byte of the arena */
+  uint16_t top;                /* bump arenas: SRAM address of the next allocation */
+} SRAMArena;
+
 /**
  * @brief Simplistic library for accessing the 32 Kilobyte 23K256 SRAM chip
  *
@@ -40,9 +71,18 @@ THE SOFTWARE.
  * Before using, call begin() to set up the SPI and initialize the chip.
  * After that, the read/write functions can be called freely to access the data.
  * Access to address 32768 and beyond wrap around back to 0.
+ *
+ * To share the chip between multiple modules, each module can create a named arena.
+ * Arenas are reserved one after the other starting at address 0, and creating an arena
+ * with a name that already exists returns the existing arena. Memory is allocated from
+ * an arena using alloc(), which returns the SRAM address to read and write. Bump arenas
+ * only release all memory at once using resetArena(), heap arenas also allow free().
+ * Do not mix arenas with reading or writing at fixed addresses.
  */
 class PHN_SRAM {
  public:
+  PHN_SRAM() : _pageAddress(SRAM_NULL), _arenaEnd(0) {}
+
   /// Initializes SPI and sets the chip up for first use
   uint8_t begin();
 
@@ -58,6 +98,10 @@ class PHN_SRAM {
   char read(uint16_t address);
   /// Writes a byte of data at an address specified
   void write(uint16_t address, char dataByte);
+  /// Fills a block of memory with the same byte of data
+  void fillBlock(uint16_t address, char dataByte, uint16_t length);
+  /// Copies a block of memory to another address, the blocks are allowed to overlap
+  void moveBlock(uint16_t destAddress, uint16_t srcAddress, uint16_t length);
   
   /// Writes a block of data and then verifies the contents by reading
   uint8_t writeBlockVerify(uint16_t address, const char* data, uint16_t length);
@@ -65,9 +109,37 @@ class PHN_SRAM {
   /// Reads in a block of data and verifies the contents
   uint8_t verifyBlock(uint16_t address, const char* data, uint16_t length);
 
+  /// Creates a named arena of the size specified, or finds the existing one. Returns SRAM_ARENA_NONE on failure
+  uint8_t createArena(const char* name, uint16_t size, uint8_t type = SRAM_ARENA_BUMP);
+  /// Finds an arena by name, returns SRAM_ARENA_NONE if not found
+  uint8_t findArena(const char* name);
+  /// Releases all memory allocated in an arena
+  void resetArena(uint8_t arena);
+  /// Removes all arenas, making the full chip available again
+  void clearArenas();
+  /// Gets the amount of bytes not yet reserved by an arena
+  uint16_t available() { return SRAM_CAPACITY - _arenaEnd; }
+  /// Allocates memory in an arena, returns SRAM_NULL if there is not enough space
+  SRAMHandle alloc(uint8_t arena, uint16_t size);
+  /// Frees memory allocated in a heap arena
+  void free(SRAMHandle handle);
+
  private:
   /// Updates the address
   void setAddress(uint8_t mode, uint16_t address);
+  /// Reads a block of data from the chip, bypassing the page cache
+  void readDirect(uint16_t address, char* data, uint16_t length);
+  /// Updates the page cache after writing data, data is NULL when filling with the same byte
+  void updatePage(uint16_t address, const char* data, char dataByte, uint16_t length);
+  /// Reads a 16-bit value, used for the heap block headers
+  uint16_t readWord(uint16_t address);
+  /// Writes a 16-bit value, used for the heap block headers
+  void writeWord(uint16_t address, uint16_t value);
+
+  char _page[SRAM_PAGE_SIZE];
+  uint16_t _pageAddress;
+  uint16_t _arenaEnd;
+  SRAMArena _arenas[SRAM_ARENA_COUNT];
 };
 
 /// Global variable from which the SRAM functions can be accessed
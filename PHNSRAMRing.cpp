@@ -0,0 +1,165 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PHNSRAMRing.h"
+
+SRAMRingBuffer::SRAMRingBuffer(SRAMHandle address, uint16_t size) {
+  _address = address;
+  _size = size - (size % SRAM_RING_STAGE_SIZE);
+  clear();
+}
+
+void SRAMRingBuffer::put(uint8_t value) {
+  put(&value, 1);
+}
+
+void SRAMRingBuffer::put(const void* data, uint8_t length) {
+  const uint8_t* src = (const uint8_t*) data;
+  uint8_t sreg = SREG;
+  cli();
+  while (length) {
+    /* All staging blocks are waiting to be written out, drop the remaining bytes */
+    if (_stagesFull == SRAM_RING_STAGES) {
+      _lost += length;
+      break;
+    }
+    _stage[_stageWrite][_stageFill++] = *src++;
+    length--;
+
+    /* Staging block is full, hand it to update() and continue with the next */
+    if (_stageFill == SRAM_RING_STAGE_SIZE) {
+      _stageFill = 0;
+      _stagesFull++;
+      if (++_stageWrite == SRAM_RING_STAGES) _stageWrite = 0;
+    }
+  }
+  SREG = sreg;
+}
+
+void SRAMRingBuffer::update() {
+  uint8_t sreg;
+  while (_stagesFull) {
+    if ((_size - _count) >= SRAM_RING_STAGE_SIZE) {
+      writeRing(_stage[_stageRead], SRAM_RING_STAGE_SIZE);
+    } else {
+      sreg = SREG;
+      cli();
+      _lost += SRAM_RING_STAGE_SIZE;
+      SREG = sreg;
+    }
+    if (++_stageRead == SRAM_RING_STAGES) _stageRead = 0;
+
+    sreg = SREG;
+    cli();
+    _stagesFull--;
+    SREG = sreg;
+  }
+}
+
+void SRAMRingBuffer::flush() {
+  uint8_t partial[SRAM_RING_STAGE_SIZE];
+  uint8_t length, sreg;
+
+  /* Drain the full staging blocks first. An interrupt can complete another one
+   * before interrupts are disabled, so check again with interrupts off and only
+   * take the partial block once no full blocks are pending, keeping the order */
+  for (;;) {
+    update();
+    sreg = SREG;
+    cli();
+    if (!_stagesFull) break;
+    SREG = sreg;
+  }
+
+  /* Take the partially filled staging block, interrupts continue filling it from the start */
+  length = _stageFill;
+  memcpy(partial, _stage[_stageWrite], length);
+  _stageFill = 0;
+  SREG = sreg;
+
+  if (length > (_size - _count)) {
+    sreg = SREG;
+    cli();
+    _lost += length - (_size - _count);
+    SREG = sreg;
+    length = _size - _count;
+  }
+  writeRing(partial, length);
+}
+
+uint16_t SRAMRingBuffer::available() {
+  update();
+  return _count;
+}
+
+int SRAMRingBuffer::read() {
+  uint8_t value;
+  return read(&value, 1) ? value : -1;
+}
+
+uint16_t SRAMRingBuffer::read(void* data, uint16_t length) {
+  char* dest = (char*) data;
+  uint16_t part;
+  update();
+  if (length > _count) length = _count;
+
+  /* Read up till the end of the ring, then continue at the start */
+  part = _size - _tail;
+  if (part > length) part = length;
+  sram.readBlock(_address + _tail, dest, part);
+  sram.readBlock(_address, dest + part, length - part);
+  _tail += length;
+  if (_tail >= _size) _tail -= _size;
+  _count -= length;
+  return length;
+}
+
+void SRAMRingBuffer::clear() {
+  uint8_t sreg = SREG;
+  cli();
+  _head = _tail = _count = 0;
+  _stageRead = _stageWrite = 0;
+  _stageFill = _stagesFull = 0;
+  _lost = 0;
+  SREG = sreg;
+}
+
+uint32_t SRAMRingBuffer::lost() {
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t count = _lost;
+  SREG = sreg;
+  return count;
+}
+
+void SRAMRingBuffer::writeRing(const uint8_t* data, uint8_t length) {
+  uint16_t part = _size - _head;
+  if (part > length) part = length;
+  sram.writeBlock(_address + _head, (const char*) data, part);
+  sram.writeBlock(_address, (const char*) data + part, length - part);
+  _head += length;
+  if (_head >= _size) _head -= _size;
+  _count += length;
+}
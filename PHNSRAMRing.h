@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/** @file
+@brief Contains the SRAMRingBuffer class for capturing data from interrupts into the external SRAM
+*/
+
+#ifndef _PHN_SRAM_RING_H_
+#define _PHN_SRAM_RING_H_
+
+#include "PHNSRAM.h"
+
+/// Amount of bytes staged in RAM before they are written to the SRAM as one block
+#define SRAM_RING_STAGE_SIZE  32
+/// Amount of staging blocks, interrupts can keep appending while the main loop writes out full blocks
+#define SRAM_RING_STAGES      2
+
+/**
+ * @brief First-in first-out buffer stored in the external SRAM, filled from interrupts
+ *
+ * Bytes are appended using put(), which is safe to call from an interrupt routine.
+ * They are collected in small staging blocks in RAM, and the main loop writes full
+ * blocks to the SRAM in one burst by calling update(). Reading moves data still staged
+ * to the SRAM first, then reads the oldest bytes. When no staging block is free, or the
+ * SRAM is full, the bytes are dropped and counted by lost().
+ *
+ * Interrupts never access the SRAM chip themselves, as the SPI bus may be in use by
+ * the main loop. When the SD card is in use, call card_setEnabled(0) before calling
+ * update(), flush() or read(), and card_setEnabled(1) afterwards.
+ *
+ * @code
+ * ISR(ADC_vect) {
+ *   capture.put(ADCH);
+ * }
+ * @endcode
+ */
+class SRAMRingBuffer {
+ public:
+  /// Creates the ring buffer using SRAM at the address specified, size is rounded down to whole staging blocks
+  SRAMRingBuffer(SRAMHandle address, uint16_t size);
+
+  /// Appends a byte, safe to call from an interrupt
+  void put(uint8_t value);
+  /// Appends a block of bytes, safe to call from an interrupt
+  void put(const void* data, uint8_t length);
+
+  /// Writes full staging blocks to the SRAM, call regularly from the main loop
+  void update();
+  /// Writes all staged bytes to the SRAM, including a partially filled staging block
+  void flush();
+  /// Gets the amount of bytes stored in the SRAM that can be read, after calling update()
+  uint16_t available();
+  /// Reads the oldest byte, returns -1 if none is available
+  int read();
+  /// Reads the oldest bytes into a buffer, returns the amount of bytes read
+  uint16_t read(void* data, uint16_t length);
+  /// Discards all bytes stored and staged, and resets the lost bytes counter
+  void clear();
+  /// Gets the amount of bytes dropped because the buffer was full
+  uint32_t lost();
+  /// Gets the total amount of bytes that can be stored in the SRAM
+  uint16_t capacity() { return _size; }
+
+ private:
+  /// Writes bytes at the head of the ring, wrapping around at the end
+  void writeRing(const uint8_t* data, uint8_t length);
+
+  SRAMHandle _address;
+  uint16_t _size;
+  uint16_t _head;
+  uint16_t _tail;
+  uint16_t _count;
+  uint8_t _stageRead;
+  volatile uint8_t _stageWrite;
+  volatile uint8_t _stageFill;
+  volatile uint8_t _stagesFull;
+  volatile uint32_t _lost;
+  uint8_t _stage[SRAM_RING_STAGES][SRAM_RING_STAGE_SIZE];
+};
+
+#endif
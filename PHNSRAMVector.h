@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/** @file
+@brief Contains the SRAMVector template class for storing arrays of structures in the external SRAM
+*/
+
+#ifndef _PHN_SRAM_VECTOR_H_
+#define _PHN_SRAM_VECTOR_H_
+
+#include "PHNSRAM.h"
+
+/**
+ * @brief Array of elements stored in the external SRAM chip
+ *
+ * The elements are stored one after the other starting at the SRAM address specified,
+ * for example memory allocated using sram.alloc(). A few pages of the array are kept
+ * in RAM, replacing the least recently used page when another is needed. Reads that
+ * fit within a page, such as single fields of an element, are then served from RAM.
+ * Use readField() with offsetof() to read only the fields needed, instead of copying
+ * the entire element:
+ *
+ * @code
+ * char sender[15];
+ * messages.readField(index, offsetof(SimMessage, sender.text), sender, sizeof(sender));
+ * @endcode
+ *
+ * Inserting and erasing elements moves the elements after it inside the SRAM.
+ */
+template<typename T, uint8_t PAGES = 2, uint8_t PAGE_SIZE = 32>
+class SRAMVector {
+ public:
+  /// Iterates the elements of the vector, dereferencing reads a copy of the element
+  class iterator {
+   public:
+    iterator(SRAMVector* vector, uint16_t index) : _vector(vector), _index(index) {}
+    T operator*() { T value; _vector->get(_index, value); return value; }
+    iterator& operator++() { _index++; return *this; }
+    bool operator!=(const iterator &other) const { return _index != other._index; }
+    /// Gets the index of the element the iterator is at
+    uint16_t index() const { return _index; }
+   private:
+    SRAMVector* _vector;
+    uint16_t _index;
+  };
+
+  /// Creates a new empty vector storing up to capacity elements at the SRAM address specified
+  SRAMVector(uint16_t address, uint16_t capacity) : _address(address), _capacity(capacity), _size(0), _use(0) {
+    for (uint8_t i = 0; i < PAGES; i++) _pages[i].offset = SRAM_NULL;
+  }
+
+  /// Gets the amount of elements stored
+  uint16_t size() const { return _size; }
+  /// Gets the maximum amount of elements that can be stored
+  uint16_t capacity() const { return _capacity; }
+  /// Gets whether no elements are stored
+  bool empty() const { return _size == 0; }
+  /// Removes all elements
+  void clear() { _size = 0; }
+
+  /// Reads an element, returns false if the index is out of range
+  bool get(uint16_t index, T &value) {
+    if (index >= _size) return false;
+    read(index * sizeof(T), &value, sizeof(T));
+    return true;
+  }
+  /// Overwrites an element, returns false if the index is out of range
+  bool set(uint16_t index, const T &value) {
+    if (index >= _size) return false;
+    write(index * sizeof(T), &value, sizeof(T));
+    return true;
+  }
+  /// Reads a copy of an element
+  T operator[](uint16_t index) { T value; get(index, value); return value; }
+
+  /// Reads part of an element, starting at the byte offset specified
+  void readField(uint16_t index, uint16_t offset, void* data, uint16_t length) {
+    read(index * sizeof(T) + offset, data, length);
+  }
+  /// Writes part of an element, starting at the byte offset specified
+  void writeField(uint16_t index, uint16_t offset, const void* data, uint16_t length) {
+    write(index * sizeof(T) + offset, data, length);
+  }
+
+  /// Adds an element at the end, returns false if the vector is full
+  bool push_back(const T &value) {
+    if (_size >= _capacity) return false;
+    write((_size++) * sizeof(T), &value, sizeof(T));
+    return true;
+  }
+  /// Removes the last element
+  void pop_back() {
+    if (_size) _size--;
+  }
+  /// Inserts an element before the index specified, returns false if the vector is full
+  bool insert(uint16_t index, const T &value) {
+    if (_size >= _capacity || index > _size) return false;
+    uint16_t offset = index * sizeof(T);
+    sram.moveBlock(_address + offset + sizeof(T), _address + offset, (_size - index) * sizeof(T));
+    invalidate(offset);
+    write(offset, &value, sizeof(T));
+    _size++;
+    return true;
+  }
+  /// Removes the element at the index specified
+  void erase(uint16_t index) {
+    if (index >= _size) return;
+    uint16_t offset = index * sizeof(T);
+    _size--;
+    sram.moveBlock(_address + offset, _address + offset + sizeof(T), (_size - index) * sizeof(T));
+    invalidate(offset);
+  }
+
+  /// Gets an iterator at the first element
+  iterator begin() { return iterator(this, 0); }
+  /// Gets an iterator past the last element
+  iterator end() { return iterator(this, _size); }
+
+ private:
+  typedef struct {
+    uint16_t offset;        /* offset of the page from the start of the vector, SRAM_NULL if unused */
+    uint8_t lastUse;        /* use counter value when last used, to find the least recently used page */
+    char data[PAGE_SIZE];
+  } Page;
+
+  /* Reads data at an offset, through a page if the data fits within one */
+  void read(uint16_t offset, void* data, uint16_t length) {
+    uint16_t pageOffset = offset - (offset % PAGE_SIZE);
+    if (length > PAGE_SIZE || (offset + length) > (pageOffset + PAGE_SIZE)) {
+      sram.readBlock(_address + offset, (char*) data, length);
+      return;
+    }
+
+    /* Find the page, or load it in place of the least recently used page */
+    Page* page = _pages;
+    Page* victim = _pages;
+    for (uint8_t i = 0; i < PAGES; i++, page++) {
+      if (page->offset == pageOffset) {
+        victim = page;
+        break;
+      }
+      if (victim->offset != SRAM_NULL && (page->offset == SRAM_NULL ||
+          (uint8_t) (_use - page->lastUse) > (uint8_t) (_use - victim->lastUse))) {
+        victim = page;
+      }
+    }
+    if (victim->offset != pageOffset) {
+      sram.readBlock(_address + pageOffset, victim->data, PAGE_SIZE);
+      victim->offset = pageOffset;
+    }
+    victim->lastUse = ++_use;
+    memcpy(data, victim->data + (offset - pageOffset), length);
+  }
+
+  /* Writes data at an offset, updating the pages it overlaps with */
+  void write(uint16_t offset, const void* data, uint16_t length) {
+    sram.writeBlock(_address + offset, (const char*) data, length);
+    for (uint8_t i = 0; i < PAGES; i++) {
+      Page &page = _pages[i];
+      if (page.offset == SRAM_NULL) continue;
+      uint16_t start = max(offset, page.offset);
+      uint16_t end = min((uint32_t) offset + length, (uint32_t) page.offset + PAGE_SIZE);
+      for (; start < end; start++) {
+        page.data[start - page.offset] = ((const char*) data)[start - offset];
+      }
+    }
+  }
+
+  /* Drops the pages at or past an offset after elements are moved */
+  void invalidate(uint16_t offset) {
+    for (uint8_t i = 0; i < PAGES; i++) {
+      if (_pages[i].offset != SRAM_NULL && (_pages[i].offset + PAGE_SIZE) > offset) {
+        _pages[i].offset = SRAM_NULL;
+      }
+    }
+  }
+
+  uint16_t _address;
+  uint16_t _capacity;
+  uint16_t _size;
+  uint8_t _use;
+  Page _pages[PAGES];
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "PHNScreenCapture.h"
+
+/* Reads pixels at the cursor straight into the block cache of the file, crossing blocks as needed */
+static void screen_capture_pixels(uint16_t count) {
+  uint16_t n;
+  while (count && volume.isInitialized) {
+    /* Limit to the pixels that still fit inside the current block */
+    n = (512 - (file_position & 0x1FF)) >> 1;
+    if (n > count) n = count;
+
+    PHNDisplay16Bit::readPixels((uint16_t*) volume_cacheCurrentBlock(1), n);
+    volume_cacheDirty = 1;
+
+    count -= n;
+    file_position += (n << 1);
+  }
+  file_size = file_position;
+}
+
+uint8_t screen_capture(const char* filename, uint8_t format,
+                       uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+  uint8_t isBMP = (format == SCREEN_CAPTURE_BMP);
+  uint32_t imageSize;
+  uint16_t row, rowPadding;
+
+  if (!file_open(filename, isBMP ? "BMP" : "LCD", SDMIN_FILE_WRITE)) return 0;
+
+  /* 
+   * Header sizes are even and pixels are 2 bytes each, so pixel
+   * data never crosses a block boundary halfway a pixel.
+   */
+  if (isBMP) {
+    /* Bitmap rows are padded to 4 bytes and stored bottom-up */
+    rowPadding = (width & 0x1) << 1;
+    imageSize = (uint32_t) ((width << 1) + rowPadding) * height;
+
+    Imageheader_BMP header;
+    const uint32_t masks[3] = {0xF800, 0x07E0, 0x001F};
+    memset(&header, 0, sizeof(header));
+    header.pixelDataOffset = 2 + sizeof(header) + sizeof(masks);
+    header.size = header.pixelDataOffset + imageSize;
+    header.headerSize = 40;
+    header.width = width;
+    header.height = height;
+    header.planes = 1;
+    header.bitCount = 16;
+    header.compression = 3; /* BI_BITFIELDS */
+    header.bitmapSize = imageSize;
+
+    file_write("BM", 2);
+    file_write((char*) &header, sizeof(header));
+    file_write((char*) masks, sizeof(masks));
+  } else {
+    /* LCD images store top-down rows without padding */
+    rowPadding = 0;
+
+    Imageheader_LCD header;
+    header.bpp = 16;
+    header.width = width;
+    header.height = height;
+    header.colors = 0;
+
+    file_write("LCD", 3);
+    file_write((char*) &header, sizeof(header));
+  }
+
+  /* Read the pixel data one row at a time, one dummy read per row */
+  for (row = 0; row < height; row++) {
+    PHNDisplay16Bit::readPixelsBegin(x, isBMP ? (y + height - 1 - row) : (y + row), DIR_RIGHT);
+    screen_capture_pixels(width);
+    if (rowPadding) {
+      const uint16_t padding = 0;
+      file_write((char*) &padding, rowPadding);
+    }
+  }
+
+  /* Write out the remaining data and the new file size */
+  file_flush();
+  return volume.isInitialized;
+}
+
+uint8_t screen_capture(const char* filename, uint8_t format) {
+  return screen_capture(filename, format, 0, 0, PHNDisplayHW::WIDTH, PHNDisplayHW::HEIGHT);
+}
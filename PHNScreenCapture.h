@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief Contains functions for capturing (a region of) the screen to the Micro-SD card
+ *
+ * Screen contents are read back from the display in bulk and are streamed into a
+ * file on the Micro-SD using the minimal SD library, one block of 512 bytes at a time.
+ * The resulting file is either a 16-bit .LCD or a 16-bit (565) .BMP image, both of
+ * which can be drawn again using the image drawing functions of the display.
+ *
+ * Coordinates are in the hardware orientation of the screen (no rotation), the full
+ * screen being 320 x 240 pixels. A full screen capture takes a few seconds.
+ */
+
+#ifndef _PHN_SCREEN_CAPTURE_H_
+#define _PHN_SCREEN_CAPTURE_H_
+
+#include "PHNDisplay.h"
+#include "PHNSDMinimal.h"
+
+/// Saves the captured screen as a 16-bit .LCD image
+#define SCREEN_CAPTURE_LCD  0
+/// Saves the captured screen as a 16-bit (565) .BMP image
+#define SCREEN_CAPTURE_BMP  1
+
+/**
+ * @brief Captures a region of the screen and saves it as an image on the Micro-SD
+ *
+ * The filename must be 8 characters long, padded with spaces at the end if needed.
+ * The extension (LCD or BMP) is selected by the format. An existing file is overwritten.
+ * Returns whether the image was successfully saved.
+ */
+uint8_t screen_capture(const char* filename, uint8_t format,
+                       uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+/// Captures the full screen and saves it as an image on the Micro-SD
+uint8_t screen_capture(const char* filename, uint8_t format);
+
+#endif
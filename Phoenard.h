@@ -40,7 +40,12 @@ THE SOFTWARE.
 #include "PHNBlueWiFi.h"
 #include "PHNMidi.h"
 #include "PHNSDMinimal.h"
+#include "PHNSDIndex.h"
 #include "PHNSRAM.h"
+#include "PHNSRAMVector.h"
+#include "PHNSRAMRing.h"
+#include "PHNScreenCapture.h"
+#include "PHNCanvas.h"
 
 // This includes <all> the widgets available in the Phoenard library
 #include "PHNWidgetAll.h"
\ No newline at end of file
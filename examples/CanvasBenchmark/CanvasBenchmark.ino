@@ -0,0 +1,89 @@
+/*
+ * Draws overlapping shapes and text into a canvas in the external SRAM,
+ * then copies the finished drawing to the screen without flicker.
+ * Before that, pixels are drawn and read back to check that drawing
+ * into the canvas stays within its bounds. The time and speed of every
+ * blit to the screen is shown on the screen and sent over Serial.
+ */
+#include "Phoenard.h"
+
+#define CANVAS_WIDTH   320   // Width of the canvas in pixels
+#define CANVAS_HEIGHT  100   // Height of the canvas in pixels, at most 102 rows of 320 fit in SRAM
+#define BLIT_REPEAT    8     // Amount of frames drawn and copied to the screen
+
+uint16_t row_y = 40;
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "Canvas Benchmark");
+
+  if (!sram.begin()) {
+    display.debugPrint(10, row_y, 2, "SRAM not found!");
+    return;
+  }
+
+  // Reserve the memory of the canvas
+  uint16_t size = CANVAS_WIDTH * CANVAS_HEIGHT;
+  SRAMHandle address = sram.alloc(sram.createArena("CANVAS", size), size);
+  if (address == SRAM_NULL) {
+    display.debugPrint(10, row_y, 2, "SRAM is full!");
+    return;
+  }
+  PHN_Canvas canvas(CANVAS_WIDTH, CANVAS_HEIGHT, address);
+
+  // Draw pixels at the edges and a rectangle past the bounds, then read them back
+  canvas.fill(0x00);
+  canvas.drawPixel(0, 0, 0x11);
+  canvas.drawPixel(CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1, 0x22);
+  canvas.fillRect(CANVAS_WIDTH - 10, 10, 20, 10, 0x33);
+  boolean pixels_ok = (canvas.readPixel(0, 0) == 0x11) &&
+                      (canvas.readPixel(CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1) == 0x22) &&
+                      (canvas.readPixel(CANVAS_WIDTH - 1, 10) == 0x33) &&
+                      (canvas.readPixel(CANVAS_WIDTH - 11, 10) == 0x00) &&
+                      (canvas.readPixel(0, 11) == 0x00);
+  result("pixels", pixels_ok ? "OK" : "FAILED");
+
+  // Draw frames with overlapping shapes and copy them to the bottom of the screen
+  uint32_t total_time = 0;
+  for (uint8_t frame = 0; frame < BLIT_REPEAT; frame++) {
+    canvas.fill(0x00);
+    for (uint8_t i = 0; i < 8; i++) {
+      uint16_t x = (frame * 8 + i * 37) % (CANVAS_WIDTH - 60);
+      canvas.fillRect(x, i * 10, 60, 30, 0x1C + i * 0x20);
+      canvas.drawRect(x, i * 10, 60, 30, 0xFF);
+    }
+    canvas.drawString(10, 80, 1, "Drawn off-screen", 0x00, 0xFF);
+    canvas.blit(0, PHNDisplayHW::HEIGHT - CANVAS_HEIGHT);
+    total_time += canvas.getBlitTime();
+  }
+
+  // Average time of a blit and the pixels (bytes) moved from SRAM to the screen per second
+  uint32_t blit_time = total_time / BLIT_REPEAT;
+  uint32_t pixels_per_sec = (uint32_t) ((float) canvas.size() * 1000000.0 / (float) blit_time);
+  result("blit us", blit_time);
+  result("pixels/s", pixels_per_sec);
+}
+
+void loop() {
+}
+
+void result(const char* name, const char* text) {
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(100, row_y, 1, text);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.println(text);
+}
+
+void result(const char* name, uint32_t value) {
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(100, row_y, 1, (float) value);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.println(value);
+}
@@ -0,0 +1,84 @@
+/*
+ * Shows how fragmented the heap becomes when widgets are created and destroyed.
+ * Labels with texts of changing length and images with palettes are created,
+ * updated and deleted many times. Afterwards the free RAM and the blocks left
+ * behind in the free list of the heap are shown on the screen and sent over Serial.
+ */
+#include "Phoenard.h"
+
+#define WORKLOAD_ROUNDS  200   // Amount of times widgets are created and destroyed
+#define WORKLOAD_LABELS  6     // Amount of labels alive at the same time
+
+// Free list of the heap maintained by malloc() and free()
+struct __freelist {
+  size_t sz;
+  struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+uint16_t row_y = 40;
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "Heap Fragmentation");
+
+  report("before");
+
+  PHN_Label* labels[WORKLOAD_LABELS] = { 0 };
+  char text[24];
+  for (uint16_t round = 0; round < WORKLOAD_ROUNDS; round++) {
+    // Replace one label, changing the texts of the others to texts of other lengths
+    uint8_t index = round % WORKLOAD_LABELS;
+    delete labels[index];
+    labels[index] = new PHN_Label();
+    for (uint8_t i = 0; i < WORKLOAD_LABELS; i++) {
+      if (labels[i]) {
+        memset(text, 'a', sizeof(text));
+        text[(round * 7 + i * 3) % (sizeof(text) - 1)] = 0;
+        labels[i]->setText(text);
+      }
+    }
+
+    // Images with palettes of varying size are copied around
+    PHN_Image image = TEXT_Image("icon");
+    PHN_Palette palette = PALETTE(BLACK, RED, WHITE, GREEN, BLUE);
+    palette.set(round % 12, YELLOW);
+    image.setPalette(palette);
+    PHN_Image copy = image;
+  }
+  for (uint8_t i = 0; i < WORKLOAD_LABELS; i++) {
+    delete labels[i];
+  }
+
+  report("after");
+}
+
+void loop() {
+}
+
+void report(const char* name) {
+  // Walk the free list to find out how much memory is stuck in between allocations
+  uint16_t blocks = 0, freeBytes = 0, largest = 0;
+  for (struct __freelist *fp = __flp; fp; fp = fp->nx) {
+    blocks++;
+    freeBytes += fp->sz;
+    largest = max(largest, fp->sz);
+  }
+
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(70, row_y, 1, (float) getFreeRAM());
+  display.debugPrint(150, row_y, 1, (float) blocks);
+  display.debugPrint(230, row_y, 1, (float) freeBytes);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": free RAM ");
+  Serial.print(getFreeRAM());
+  Serial.print(", free list ");
+  Serial.print(blocks);
+  Serial.print(" blocks, ");
+  Serial.print(freeBytes);
+  Serial.print(" bytes, largest ");
+  Serial.println(largest);
+}
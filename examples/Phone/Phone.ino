@@ -34,6 +34,15 @@ PHN_PhoneHeader header;
 
 const color_t BUTTON_COLOR = PHNDisplayHW::color565(255, 240, 100);
 
+// Allocates SRAM memory for the contacts or messages screen
+// Only one screen is shown at a time, so both share the same arena
+SRAMHandle allocPhoneSRAM(uint16_t size) {
+  sram.begin();
+  uint8_t arena = sram.createArena("PHONE", sram.available());
+  sram.resetArena(arena);
+  return sram.alloc(arena, size);
+}
+
 void setup() {
   Serial.begin(57600);
 
@@ -37,9 +37,12 @@
 /* Amount of contacts showed at one time (page size) */
 const int CONTACT_PAGE_SIZE = 10;
 
+/* Contacts read from the SIM, stored in SRAM */
+SRAMHandle contacts_sram;
+
 void showContacts(const char* phoneBook, boolean allowEditing) {
   // Initialize sram as needed
-  sram.begin();
+  contacts_sram = allocPhoneSRAM(SRAM_CAPACITY - (SRAM_CAPACITY % sizeof(SimContact)));
   
   // Set SIM to use the phone book specified
   sim.setContactBook(phoneBook);
@@ -85,7 +88,7 @@ void showContacts(const char* phoneBook, boolean allowEditing) {
 
       // Set the 'valid' byte field to 0 for all entries displayed
       for (int i = 0; i < list.itemCount(); i++) {
-        sram.write(i * sizeof(SimContact), 0);
+        sram.write(contacts_sram + i * sizeof(SimContact), 0);
       }
     }
 
@@ -97,7 +100,7 @@ void showContacts(const char* phoneBook, boolean allowEditing) {
       if (readSimIndex < contactLimit) {
         SimContact nextContact = sim.getContact(readSimIndex++);
         if (nextContact.valid) {
-          sram.writeSegment(readIndex, &nextContact, sizeof(SimContact));
+          sram.writeBlock(contacts_sram + readIndex * sizeof(SimContact), (char*) &nextContact, sizeof(SimContact));
           list.drawItem(readIndex);
           readIndex++;
         }
@@ -133,7 +136,7 @@ void showContacts(const char* phoneBook, boolean allowEditing) {
 
     if (header.isAccepted()) {
       SimContact contact;
-      sram.readSegment(selIndex, &contact, sizeof(SimContact));
+      sram.readBlock(contacts_sram + selIndex * sizeof(SimContact), (char*) &contact, sizeof(SimContact));
       if (contact.valid) {     
         // Hide listing
         list.setVisible(false);
@@ -316,7 +319,7 @@ boolean editContact(SimContact &contact) {
 
 void contactDrawFunc(ItemParam &p) {
   SimContact contact;
-  sram.readSegment(p.index, &contact, sizeof(SimContact));
+  sram.readBlock(contacts_sram + p.index * sizeof(SimContact), (char*) &contact, sizeof(SimContact));
   const char* text;
   const char* number;
   if (contact.valid) {
@@ -5,10 +5,14 @@
 /* Amount of contacts showed at one time (page size) */
 const int MESSAGES_PAGE_SIZE = 7;
 
+/* Messages read from the SIM, stored in SRAM */
+const uint16_t MESSAGES_CAPACITY = SRAM_CAPACITY / sizeof(SimMessage);
+SRAMVector<SimMessage> messages(SRAM_NULL, 0);
+
 /* Shows a list of inbox messages stored on the SIM */
 void showMessages() {
   // Initialize SRAM as needed
-  sram.begin();
+  messages = SRAMVector<SimMessage>(allocPhoneSRAM(MESSAGES_CAPACITY * sizeof(SimMessage)), MESSAGES_CAPACITY);
   
   PHN_ItemList list;
   list.setBounds(10, 20, 300, 170);
@@ -35,10 +39,8 @@ void showMessages() {
       readSimIndex = 0;
       list.setItemCount(sim.getMessageCount());
 
-      // Set the 'valid' byte field to 0 for all entries displayed
-      for (int i = 0; i < list.itemCount(); i++) {
-        sram.write(i * sizeof(SimMessage), 0);
-      }
+      // Entries past the messages read so far are displayed as not yet loaded
+      messages.clear();
     }
 
     // Refresh widgets
@@ -47,8 +49,7 @@ void showMessages() {
     // Read messages every loop
     if ((readIndex < list.itemCount()) && (readSimIndex < messageLimit)) {
       SimMessage nextMessage = sim.getMessage(readSimIndex++);
-      if (nextMessage.valid) {
-        sram.writeSegment(readIndex, &nextMessage, sizeof(SimMessage));
+      if (nextMessage.valid && messages.push_back(nextMessage)) {
         list.drawItem(readIndex);
         readIndex++;
       }
@@ -57,8 +58,7 @@ void showMessages() {
     // If accepted, show the message
     if (header.isAccepted()) {
       SimMessage message;
-      sram.readSegment(list.selectedIndex(), &message, sizeof(SimMessage));
-      if (message.valid) {
+      if (messages.get(list.selectedIndex(), message)) {
         list.setVisible(false);
 
         // Show message, reload if message was changed / deleted
@@ -250,27 +250,30 @@ void sendMessage(const char* number) {
 }
 
 void messageDrawFunc(ItemParam &p) {
-  SimMessage message;
-  sram.readSegment(p.index, &message, sizeof(SimMessage));
-
   display.fillRect(p.x, p.y, p.w, p.h, p.color);
   display.setTextColor(BLACK, p.color);
-  if (message.valid) {
+  if (p.index < messages.size()) {
     // Loaded, show message preview
-    const char* text = message.text;
-    const char* sender;
-    if (message.sender.text[0]) {
-      sender = message.sender.text;
-    } else {
-      sender = message.sender.number;
+    // Only the fields shown are read, instead of the entire message
+    const int line_len = 30;
+    Date date;
+    char sender[15];
+    char text[line_len*2+1];
+    messages.readField(p.index, offsetof(SimMessage, date), &date, sizeof(date));
+    messages.readField(p.index, offsetof(SimMessage, sender.text), sender, sizeof(sender));
+    if (!sender[0]) {
+      messages.readField(p.index, offsetof(SimMessage, sender.number), sender, sizeof(sender));
     }
+    messages.readField(p.index, offsetof(SimMessage, text), text, sizeof(text));
+    sender[sizeof(sender)-1] = 0;
+    text[sizeof(text)-1] = 0;
 
     // First print the date
     display.setTextSize(1);
     display.setCursor(p.x+3, p.y+3);
-    display.printDate(message.date);
+    display.printDate(date);
     display.print(' ');
-    display.printShortTime(message.date);
+    display.printShortTime(date);
     
     // Then draw the name or address of the sender below it
     display.setCursor(p.x+3, p.y+13);
@@ -285,7 +288,6 @@ void messageDrawFunc(ItemParam &p) {
     // Draw part of the message next to this
     display.setCursor(p.x+97, p.y+3);
     display.setTextColor(GRAY, p.color);
-    const int line_len = 30;
     for (int i = 0; i < (line_len*2) && text[i]; i++) {
       if (i == line_len) {
         display.setCursor(p.x+97, p.y+13);
@@ -0,0 +1,163 @@
+/*
+ * Measures the speed of writing and reading a file on the Micro-SD card,
+ * first using a command for every block and then using multi-block streaming.
+ * The file data is checked after reading it back, and the file is deleted
+ * afterwards. For writing, the amount of blocks written besides the file data,
+ * such as FAT and directory blocks, is shown per cluster. This drops when more
+ * cache slots are configured using VOLUME_CACHE_SLOTS in PHNSDMinimal.h.
+ * Finally the first block is overwritten after seeking back to the start,
+ * and the whole file is read back to check the other blocks are kept.
+ * The results are shown on the screen and sent over Serial.
+ */
+#include "Phoenard.h"
+
+#define BENCH_FILE_BLOCKS  512        // Amount of 512-byte blocks written and read (256 KB)
+#define BENCH_FILE_NAME    "SDBENCH "  // Name of the file used, padded to 8 characters
+#define BENCH_FILE_EXT     "DAT"
+
+char buffer[512];
+uint16_t row_y = 40;
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "SD Benchmark");
+
+  if (!volume_init()) {
+    display.debugPrint(10, row_y, 2, "SD card not found!");
+    return;
+  }
+
+  display.debugPrint(10, row_y, 1, "test");
+  display.debugPrint(110, row_y, 1, "KB/s");
+  display.debugPrint(170, row_y, 1, "blocks");
+  display.debugPrint(230, row_y, 1, "data");
+  row_y += 12;
+
+  benchmark("single", false);
+  benchmark("streaming", true);
+  volume_setStreaming(false);
+  overwrite();
+
+  display.debugPrint(10, row_y, 1, "cache slots");
+  display.debugPrint(110, row_y, 1, VOLUME_CACHE_SLOTS);
+  Serial.print("cache slots: ");
+  Serial.println(VOLUME_CACHE_SLOTS);
+
+  // Remove the file again
+  if (file_open(BENCH_FILE_NAME, BENCH_FILE_EXT, SDMIN_FILE_READ)) {
+    file_delete();
+  }
+}
+
+void loop() {
+}
+
+void benchmark(const char* name, boolean streaming) {
+  uint32_t start, time;
+  uint16_t block, i;
+  boolean data_ok = true;
+
+  volume_setStreaming(streaming);
+
+  // Write the file, every block holding a pattern that depends on the block number
+  if (!file_open(BENCH_FILE_NAME, BENCH_FILE_EXT, SDMIN_FILE_WRITE)) {
+    result(name, "write", 0, 0, false);
+    return;
+  }
+  card_resetStats();
+  start = micros();
+  for (block = 0; block < BENCH_FILE_BLOCKS; block++) {
+    for (i = 0; i < sizeof(buffer); i++) {
+      buffer[i] = (char) (block + i);
+    }
+    file_write(buffer, sizeof(buffer));
+  }
+  file_flush();
+  time = micros() - start;
+  result(name, "write", time, card_stats.writeCount, volume.isInitialized);
+
+  // Blocks written besides the file data, such as FAT and directory blocks, per cluster
+  uint32_t clusters = (BENCH_FILE_BLOCKS + volume.blocksPerCluster - 1) / volume.blocksPerCluster;
+  float extra = (float) (card_stats.writeCount - BENCH_FILE_BLOCKS) / (float) clusters;
+  display.debugPrint(70, row_y, 1, "extra/cluster");
+  display.debugPrint(170, row_y, 1, extra);
+  row_y += 12;
+  Serial.print(name);
+  Serial.print(" extra writes per cluster: ");
+  Serial.println(extra);
+
+  // Read the file back and check the pattern
+  if (!file_open(BENCH_FILE_NAME, BENCH_FILE_EXT, SDMIN_FILE_READ)) {
+    result(name, "read", 0, 0, false);
+    return;
+  }
+  card_resetStats();
+  start = micros();
+  for (block = 0; block < BENCH_FILE_BLOCKS; block++) {
+    char* data = file_read(512);
+    for (i = 0; i < sizeof(buffer); i++) {
+      if (data[i] != (char) (block + i)) data_ok = false;
+    }
+  }
+  time = micros() - start;
+  result(name, "read", time, card_stats.readCount, data_ok && volume.isInitialized);
+}
+
+void overwrite() {
+  uint32_t start, time;
+  uint16_t block, i;
+  boolean data_ok;
+
+  // Open the file without wiping it, seek back to the start and overwrite the first block
+  if (!file_open(BENCH_FILE_NAME, BENCH_FILE_EXT, SDMIN_FILE_CREATE)) {
+    result("seek 0", "write", 0, 0, false);
+    return;
+  }
+  file_read(512);
+  file_seek(0);
+  for (i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = (char) ~i;
+  }
+  file_write(buffer, sizeof(buffer));
+  file_flush();
+
+  // Read the whole file back, only the first block must have changed
+  if (!file_open(BENCH_FILE_NAME, BENCH_FILE_EXT, SDMIN_FILE_READ)) {
+    result("seek 0", "read", 0, 0, false);
+    return;
+  }
+  data_ok = (file_size == (uint32_t) BENCH_FILE_BLOCKS * 512);
+  card_resetStats();
+  start = micros();
+  for (block = 0; block < BENCH_FILE_BLOCKS; block++) {
+    char* data = file_read(512);
+    for (i = 0; i < sizeof(buffer); i++) {
+      if (data[i] != (block ? (char) (block + i) : (char) ~i)) data_ok = false;
+    }
+  }
+  time = micros() - start;
+  result("seek 0", "read", time, card_stats.readCount, data_ok && volume.isInitialized);
+}
+
+void result(const char* name, const char* operation, uint32_t time, uint32_t blocks, boolean ok) {
+  // Compute kilobytes per second (including the time spent filling and checking the data)
+  uint32_t kb_per_sec = time ? (uint32_t) ((float) BENCH_FILE_BLOCKS * 512.0 / 1024.0 * 1000000.0 / (float) time) : 0;
+
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(70, row_y, 1, operation);
+  display.debugPrint(110, row_y, 1, (float) kb_per_sec);
+  display.debugPrint(170, row_y, 1, (float) blocks);
+  display.debugPrint(230, row_y, 1, ok ? "OK" : "FAILED");
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(" ");
+  Serial.print(operation);
+  Serial.print(": ");
+  Serial.print(kb_per_sec);
+  Serial.print(" KB/s, ");
+  Serial.print(blocks);
+  Serial.print(" blocks, data ");
+  Serial.println(ok ? "OK" : "FAILED");
+}
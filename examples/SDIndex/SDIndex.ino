@@ -0,0 +1,117 @@
+/*
+ * Measures opening files in a large root directory on the Micro-SD card,
+ * scanning the directory and looking the files up using the directory index.
+ * A few thousand files are created first, which takes a few minutes the
+ * first time only. Both ways of opening must find the same directory entries.
+ * The results are shown on the screen and sent over Serial.
+ *
+ * A FAT16 root directory holds at most 512 entries, use a FAT32 card.
+ */
+#include "Phoenard.h"
+
+#define INDEX_FILES    2000   // Amount of files in the root directory to test with
+#define INDEX_SLOTS    4096   // Amount of slots of the index, 5 bytes of SRAM each
+#define OPEN_STEP      10     // Only every so many files are opened, scanning is slow
+#define DELETE_FILES   0      // Set to 1 to delete the files again afterwards
+
+char name_buff[9];
+uint16_t row_y = 40;
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "SD Index");
+
+  if (!sram.begin()) {
+    display.debugPrint(10, row_y, 2, "SRAM not found!");
+    return;
+  }
+  if (!volume_init()) {
+    display.debugPrint(10, row_y, 2, "SD card not found!");
+    return;
+  }
+
+  // Reserve the SRAM for the index
+  uint16_t size = INDEX_SLOTS * sizeof(FilePtr);
+  SRAMHandle address = sram.alloc(sram.createArena("SDIDX", size), size);
+  if (address == SRAM_NULL || !dir_index_build(address, INDEX_SLOTS)) {
+    display.debugPrint(10, row_y, 2, "Index failed!");
+    return;
+  }
+
+  // Create the files that do not exist yet, files found using the index are opened quickly
+  uint16_t count;
+  for (count = 0; count < INDEX_FILES; count++) {
+    if (!file_open_indexed(fileName(count), "TST", SDMIN_FILE_CREATE)) break;
+  }
+  result("files", count);
+
+  // Build the index again, now for all files
+  uint32_t start = micros();
+  boolean built = dir_index_build(address, INDEX_SLOTS);
+  uint32_t build_time = micros() - start;
+  result("build us", build_time);
+  result("index", built ? "OK" : "FAILED");
+  if (!built) return;
+
+  // Open the files by scanning the directory, then using the index
+  uint32_t scan_time = 0;
+  uint32_t index_time = 0;
+  uint16_t opened = 0;
+  boolean same = true;
+  for (uint16_t i = 0; i < count; i += OPEN_STEP) {
+    start = micros();
+    boolean found_scan = file_open(fileName(i), "TST", SDMIN_FILE_READ);
+    scan_time += micros() - start;
+    FilePtr entry = file_curDir;
+
+    start = micros();
+    boolean found_index = file_open_indexed(fileName(i), "TST", SDMIN_FILE_READ);
+    index_time += micros() - start;
+
+    if (!found_scan || !found_index || entry.block != file_curDir.block || entry.index != file_curDir.index) {
+      same = false;
+    }
+    opened++;
+  }
+  if (opened) {
+    result("scan us", scan_time / opened);
+    result("index us", index_time / opened);
+  }
+  result("entries", same ? "OK" : "FAILED");
+
+#if DELETE_FILES
+  for (uint16_t i = 0; i < count; i++) {
+    if (file_open(fileName(i), "TST", SDMIN_FILE_READ)) file_delete();
+  }
+#endif
+}
+
+void loop() {
+}
+
+// Gets the 8-character name of a test file
+const char* fileName(uint16_t index) {
+  sprintf(name_buff, "IDX%05u", index);
+  return name_buff;
+}
+
+void result(const char* name, const char* text) {
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(100, row_y, 1, text);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.println(text);
+}
+
+void result(const char* name, uint32_t value) {
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(100, row_y, 1, (float) value);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.println(value);
+}
@@ -0,0 +1,70 @@
+/*
+ * Measures the transfer speed of the external SRAM chip.
+ * Blocks of 32 bytes, 512 bytes and the full 32 KB are written and read
+ * back, showing the bytes per second and CPU cycles per byte achieved.
+ * The results are shown on the screen and sent over Serial.
+ */
+#include "Phoenard.h"
+
+#define BENCH_REPEAT  16   // Amount of times small transfers are repeated to measure them
+
+char buffer[512];
+uint16_t row_y = 40;
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "SRAM Benchmark");
+
+  if (!sram.begin()) {
+    display.debugPrint(10, row_y, 2, "SRAM not found!");
+    return;
+  }
+
+  // Fill the buffer with some data to write
+  for (uint16_t i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = (char) i;
+  }
+
+  // 32 and 512 byte transfers, repeated to get a measurable time
+  benchmark("write 32", 32, BENCH_REPEAT, false);
+  benchmark("read 32", 32, BENCH_REPEAT, true);
+  benchmark("write 512", 512, BENCH_REPEAT, false);
+  benchmark("read 512", 512, BENCH_REPEAT, true);
+
+  // The full 32 KB, transferred using 64 blocks of 512 bytes
+  benchmark("write 32K", 512, 64, false);
+  benchmark("read 32K", 512, 64, true);
+}
+
+void loop() {
+}
+
+void benchmark(const char* name, uint16_t length, uint16_t count, boolean read) {
+  uint32_t bytes = (uint32_t) length * count;
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < count; i++) {
+    if (read) {
+      sram.readBlock(i * length, buffer, length);
+    } else {
+      sram.writeBlock(i * length, buffer, length);
+    }
+  }
+  uint32_t time = micros() - start;
+
+  // Compute bytes per second and CPU cycles per byte (including call overhead)
+  uint32_t bytes_per_sec = (uint32_t) ((float) bytes * 1000000.0 / (float) time);
+  float cycles_per_byte = (float) time * (float) (F_CPU / 1000000) / (float) bytes;
+
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(100, row_y, 1, (float) bytes_per_sec);
+  display.debugPrint(200, row_y, 1, cycles_per_byte);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(bytes_per_sec);
+  Serial.print(" bytes/s, ");
+  Serial.print(cycles_per_byte);
+  Serial.println(" cycles/byte");
+}
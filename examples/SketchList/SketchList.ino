@@ -125,12 +125,16 @@ typedef struct {
 
 /*
  * The first 100 sketch entries (1.2kb) are stored in internal RAM
- * The remaining ~2730 entries are stored on the External SRAM chip
+ * The remaining ~2730 entries are stored in an arena on the External SRAM chip
+ * Sketch addresses are relative to the SRAM memory, negative for internal RAM
  */
 SketchInfo sketches_buff[100];
 int sketches_buff_cnt = 0;
 const int sketches_sram_start = -sizeof(sketches_buff);
+SRAMHandle sketches_sram;
+uint16_t sketches_sram_size = 0;
 boolean sketches_reachedEnd = false;
+DirIterator sketches_dir;
 
 /* Variables used by the main sketch list showing logic */
 char sketch_icon_text[MENU_IDX_CNT][9];
@@ -144,6 +148,11 @@ long pressed_time_start;
 void setup() {
   /* Initialize SRAM for buffering >100 sketches */
   sram.begin();
+  sketches_sram_size = sram.available() - (sram.available() % sizeof(SketchInfo));
+  sketches_sram = sram.alloc(sram.createArena("SKETCH", sketches_sram_size), sketches_sram_size);
+  if (sketches_sram == SRAM_NULL) {
+    sketches_sram_size = 0;
+  }
 }
 
 void loop() {
@@ -166,6 +175,7 @@ void loop() {
     sketches_buff_cnt = 0;
     sketches_reachedEnd = false;
     volume_init(1);
+    dir_iterator_begin(&sketches_dir, 0, NULL);
     reloadAll = false;
     PHNDisplay8Bit::fill(COLOR_MENU_BG);
   }
@@ -188,25 +198,23 @@ void loop() {
   uint8_t icon_h;         /* Height of the icon */
   uint8_t icon_idx;       /* Icon index in main sketch menu */
   int16_t sketch_index;   /* Index in the sketch buffer */
-  int16_t sketch_addr;    /* SRAM address in the sketch buffer */
+  int16_t sketch_addr;    /* Address relative to the SRAM sketch memory */
   SketchInfo sketch_info; /* Sketch entry information */
 
   /* Routinely buffer in sketch information from the Micro-SD in the background */
   for (uint8_t i = 0; i < 16 && !sketches_reachedEnd; i++) {
-    /* Read next directory entry */
-    SDMINFAT::dir_t* p = (SDMINFAT::dir_t*) file_read(32);
-
-    /* Reached the end of the root directory? */
-    if (p->name[0] == SDMINFAT::DIR_NAME_FREE) {
+    /* Read next directory entry, reached the end of the root directory? */
+    DirEntryInfo entry;
+    DirEntryInfo* p = &entry;
+    if (!dir_iterator_next(&sketches_dir, p)) {
       sketches_reachedEnd = true;
       break;
     }
 
-    /* Make sure hidden (OS) files are not displayed */
-    if (p->attributes & SDMINFAT::DIR_ATT_HIDDEN) continue;
+    /* Make sure hidden (OS) files and directories are not displayed */
+    if (p->attributes & (SDMINFAT::DIR_ATT_HIDDEN | SDMINFAT::DIR_ATT_DIRECTORY)) continue;
 
-    /* Check if not deleted / main sketch */
-    if (p->name[0] == SDMINFAT::DIR_NAME_DELETED) continue;
+    /* Check if not main sketch */
     if (!memcmp("SKETCHES", p->name, 8)) continue;
 
     /* Do not display files starting with _ (Mac OSx meta files) */
@@ -224,7 +232,7 @@ void loop() {
       if (sketch_addr >= 0) {
         /* Reading SRAM space - turn the SD-card off */
         card_setEnabled(false);
-        create_new = !sram.verifyBlock(sketch_addr, (char*) p->name, 8);
+        create_new = !sram.verifyBlock(sketches_sram + sketch_addr, (char*) p->name, 8);
       } else {
         create_new = memcmp(sketches_buff[sketch_index].name, p->name, 8);
       }
@@ -235,23 +243,23 @@ void loop() {
       sketch_addr += sizeof(SketchInfo);
     }
 
-    /* Create new entry if not found */
+    /* Create new entry if not found, as long as there is space left */
     if (create_new) {
+      if (sketch_addr >= (int16_t) sketches_sram_size) continue;
       sketches_buff_cnt++;
       memcpy(sketch_info.name, p->name, 8);
       sketch_info.icon = 0;
       if (sketch_addr >= 0) {
-        sram.writeBlock(sketch_addr, (char*) &sketch_info, sizeof(SketchInfo));
+        sram.writeBlock(sketches_sram + sketch_addr, (char*) &sketch_info, sizeof(SketchInfo));
       } else {
         sketches_buff[sketch_index] = sketch_info;
       }
     }
     /* If SKI file, set icon location info */
     if (is_ski) {
-      uint32_t icon_cluster = ((uint32_t) p->firstClusterHigh << 16) | p->firstClusterLow;
-      uint32_t icon_block = volume_firstClusterBlock(icon_cluster);
+      uint32_t icon_block = volume_firstClusterBlock(p->firstCluster);
       if (sketch_addr >= 0) {
-        sram.writeBlock(sketch_addr + 8, (char*) &icon_block, sizeof(uint32_t));
+        sram.writeBlock(sketches_sram + sketch_addr + 8, (char*) &icon_block, sizeof(uint32_t));
       } else {
         sketches_buff[sketch_index].icon = icon_block;
       }
@@ -310,7 +318,7 @@ void loop() {
           sketch_addr = sketches_sram_start + sketch_index * sizeof(SketchInfo);
           if (sketch_addr >= 0) {
             card_setEnabled(false);
-            sram.readBlock(sketch_addr, (char*) &sketch_info, sizeof(SketchInfo));
+            sram.readBlock(sketches_sram + sketch_addr, (char*) &sketch_info, sizeof(SketchInfo));
             card_setEnabled(true);
           } else {
             sketch_info = sketches_buff[sketch_index];
@@ -0,0 +1,125 @@
+/*
+ * Measures the read speed of the stream wrappers.
+ * A block of RAM is read using a MemoryStream, and using a BufferedReadStream
+ * on top of it, one byte at a time and in blocks using readBytes().
+ * Before that, the data read through a BufferedReadStream is checked, also for
+ * a source that only has a few bytes available at a time, like Serial.
+ * The results are shown on the screen and sent over Serial.
+ */
+#include "Phoenard.h"
+
+#define BENCH_DATA_SIZE  1024   // Amount of bytes read by every benchmark
+#define BENCH_REPEAT     16     // Amount of times the data is read to measure it
+
+char data[BENCH_DATA_SIZE];
+char buffer[256];
+uint16_t row_y = 40;
+
+// Stream reading RAM that only has a few bytes available at a time
+class TrickleStream : public Stream {
+ public:
+  TrickleStream(const char* data, uint16_t length) : _data(data), _length(length), _pos(0) {}
+  int available() { return min(_length - _pos, 3); }
+  int read() { return (_pos < _length) ? (uint8_t) _data[_pos++] : -1; }
+  int peek() { return (_pos < _length) ? (uint8_t) _data[_pos] : -1; }
+  size_t write(uint8_t val) { return 0; }
+ private:
+  const char* _data;
+  uint16_t _length;
+  uint16_t _pos;
+};
+
+void setup() {
+  Serial.begin(57600);
+  display.setTextColor(GREEN);
+  display.debugPrint(10, 10, 2, "Stream Benchmark");
+
+  // Fill the data with something to read
+  for (uint16_t i = 0; i < sizeof(data); i++) {
+    data[i] = (char) i;
+  }
+
+  // Check the data read, from a chunk stream and from a stream with little data available
+  MemoryStream memory(data, sizeof(data));
+  BufferedReadStream memoryBuffered(&memory, 64);
+  check("check memory", memoryBuffered, true);
+
+  TrickleStream trickle(data, sizeof(data));
+  trickle.setTimeout(10);
+  BufferedReadStream trickleBuffered(&trickle, 64);
+  check("check trickle", trickleBuffered, false);
+
+  benchmark("memory read()", false, 0);
+  benchmark("memory 256", false, 256);
+  benchmark("buffered read()", true, 0);
+  benchmark("buffered 16", true, 16);
+  benchmark("buffered 256", true, 256);
+}
+
+void loop() {
+}
+
+void check(const char* name, BufferedReadStream &stream, boolean checkAvailable) {
+  // Reads smaller and larger than the buffer of 64 bytes, crossing its boundaries
+  const uint16_t sizes[] = {1, 10, 100, 63, 200, 5};
+  uint16_t pos = 0;
+  boolean ok = true;
+  for (uint8_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+    if (checkAvailable && stream.available() != (int) (sizeof(data) - pos)) ok = false;
+    if (stream.peek() != (uint8_t) data[pos]) ok = false;
+    if (stream.readBytes(buffer, sizes[i]) != sizes[i]) ok = false;
+    if (memcmp(buffer, data + pos, sizes[i])) ok = false;
+    pos += sizes[i];
+  }
+
+  // Read the remainder one byte at a time, after which the end is reached
+  int c;
+  while (pos <= sizeof(data) && (c = stream.read()) != -1) {
+    if (pos == sizeof(data) || c != (uint8_t) data[pos]) ok = false;
+    pos++;
+  }
+  if (pos != sizeof(data) || stream.readBytes(buffer, 16) != 0) ok = false;
+
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(120, row_y, 1, ok ? "OK" : "FAILED");
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.println(ok ? "OK" : "FAILED");
+}
+
+void benchmark(const char* name, boolean buffered, uint16_t blockSize) {
+  uint32_t bytes = (uint32_t) BENCH_DATA_SIZE * BENCH_REPEAT;
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < BENCH_REPEAT; i++) {
+    MemoryStream memory(data, sizeof(data));
+    BufferedReadStream bufferedStream(&memory, 64);
+    Stream &stream = buffered ? (Stream&) bufferedStream : (Stream&) memory;
+
+    if (!blockSize) {
+      while (stream.read() != -1);
+    } else if (buffered) {
+      while (bufferedStream.readBytes(buffer, blockSize));
+    } else {
+      while (memory.readBytes(buffer, blockSize));
+    }
+  }
+  uint32_t time = micros() - start;
+
+  // Compute bytes per second and CPU cycles per byte (including call overhead)
+  uint32_t bytes_per_sec = (uint32_t) ((float) bytes * 1000000.0 / (float) time);
+  float cycles_per_byte = (float) time * (float) (F_CPU / 1000000) / (float) bytes;
+
+  display.debugPrint(10, row_y, 1, name);
+  display.debugPrint(120, row_y, 1, (float) bytes_per_sec);
+  display.debugPrint(220, row_y, 1, cycles_per_byte);
+  row_y += 12;
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(bytes_per_sec);
+  Serial.print(" bytes/s, ");
+  Serial.print(cycles_per_byte);
+  Serial.println(" cycles/byte");
+}
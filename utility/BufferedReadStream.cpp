@@ -27,44 +27,133 @@ THE SOFTWARE.
 
 BufferedReadStream::BufferedReadStream(Stream *baseStream, int bufferSize) {
   _baseStream = baseStream;
-  _bufferLen = bufferSize;
-  _bufferPos = bufferSize;
-  _buffer = new unsigned char[bufferSize];
+  _chunks = NULL;
+  _refill = NULL;
+  _bufferSize = bufferSize;
+  _bufferFill = 0;
+  _bufferPos = 0;
+  _buffer = new uint8_t[bufferSize];
+}
+
+BufferedReadStream::BufferedReadStream(ChunkStream *baseStream, int bufferSize) {
+  _baseStream = baseStream;
+  _chunks = baseStream;
+  _refill = NULL;
+  _bufferSize = bufferSize;
+  _bufferFill = 0;
+  _bufferPos = 0;
+  _buffer = new uint8_t[bufferSize];
+}
+
+BufferedReadStream::BufferedReadStream(BufferedReadRefill refill, int bufferSize) {
+  _baseStream = NULL;
+  _chunks = NULL;
+  _refill = refill;
+  _bufferSize = bufferSize;
+  _bufferFill = 0;
+  _bufferPos = 0;
+  _buffer = new uint8_t[bufferSize];
 }
 
 BufferedReadStream::~BufferedReadStream() {
   delete[] _buffer;
 }
 
-inline void BufferedReadStream::refreshBuffer() {
-  if (_bufferPos == _bufferLen) {
+size_t BufferedReadStream::readSource(uint8_t* data, size_t length) {
+  if (_refill) {
+    return _refill(data, length);
+  }
+  if (_chunks) {
+    return _chunks->readChunks(data, length);
+  }
+  // Only read what is available, so reading a single byte does not wait for a full buffer
+  int avail = _baseStream->available();
+  if (avail <= 0) {
+    return 0;
+  }
+  return _baseStream->readBytes((char*) data, min(length, (size_t) avail));
+}
+
+inline uint16_t BufferedReadStream::refreshBuffer() {
+  if (_bufferPos == _bufferFill) {
     _bufferPos = 0;
-    _baseStream->readBytes((char*) _buffer, min(_bufferLen, _baseStream->available()));
+    _bufferFill = readSource(_buffer, _bufferSize);
   }
+  return _bufferFill - _bufferPos;
 }
 
 int BufferedReadStream::peek() {
-  refreshBuffer();
+  if (!refreshBuffer()) {
+    return -1;
+  }
   return _buffer[_bufferPos];
 }
 
 int BufferedReadStream::read() {
-  refreshBuffer();
-  if (_bufferLen) {
-    return _buffer[_bufferPos++];
-  } else {
+  if (!refreshBuffer()) {
     return -1;
   }
+  return _buffer[_bufferPos++];
 }
 
 int BufferedReadStream::available() {
-  return _bufferLen - _bufferPos + _baseStream->available();
+  uint32_t count = _bufferFill - _bufferPos;
+  if (_baseStream) {
+    count += _baseStream->available();
+  }
+  return min(count, 0x7fff);
 }
 
 void BufferedReadStream::flush() {
-  _baseStream->flush();
+  if (_baseStream) {
+    _baseStream->flush();
+  }
+}
+
+size_t BufferedReadStream::readBytes(char* buffer, size_t length) {
+  uint8_t* dest = (uint8_t*) buffer;
+  size_t total = 0;
+  uint16_t count;
+  while (length) {
+    // Large blocks are read from the source straight into the destination
+    // Other streams only read one byte at a time, for those the buffer is filled instead
+    if (_bufferPos == _bufferFill && length >= _bufferSize && (_refill || _chunks)) {
+      total += readSource(dest, length);
+      break;
+    }
+
+    // Copy out of the buffer, the source is only read when the buffer is empty
+    count = refreshBuffer();
+    if (!count) {
+      // Nothing available right now, wait for the remainder like Stream does
+      if (_baseStream && !_chunks) {
+        total += _baseStream->readBytes((char*) dest, length);
+      }
+      break;
+    }
+    if (count > length) {
+      count = length;
+    }
+    memcpy(dest, _buffer + _bufferPos, count);
+    _bufferPos += count;
+    dest += count;
+    total += count;
+    length -= count;
+  }
+  return total;
+}
+
+size_t BufferedReadStream::acquireChunk(const uint8_t** ptr, size_t max) {
+  // Chunks are served from the buffer
+  uint16_t count = refreshBuffer();
+  *ptr = _buffer + _bufferPos;
+  return min((size_t) count, max);
+}
+
+void BufferedReadStream::releaseChunk(size_t count) {
+  _bufferPos += count;
 }
 
 size_t BufferedReadStream::write(uint8_t val) {
-  return _baseStream->write(val);
-}
\ No newline at end of file
+  return _baseStream ? _baseStream->write(val) : 0;
+}
@@ -29,31 +29,57 @@ THE SOFTWARE.
  */
 
 #include <Arduino.h>
+#include "ChunkStream.h"
 
 #ifndef _BUFF_READ_STREAM_H_
 #define _BUFF_READ_STREAM_H_
 
+/// Function filling a buffer with the next data, returns the amount of bytes stored (0 at the end)
+typedef size_t (*BufferedReadRefill)(uint8_t* buffer, size_t size);
+
 /**
  * @brief Buffered stream implementation for reading another stream with a buffer
  *
  * Reads in multiple bytes at once into the buffer, allowing faster reading if the
- * original stream byte-by-byte reading function is too slow.
+ * original stream byte-by-byte reading function is too slow. Reading blocks of data
+ * copies them out of the buffer. When reading from a ChunkStream or a refill function,
+ * blocks larger than the buffer are read from the source straight into the destination.
+ *
+ * Instead of a stream, a refill function can be specified as the source. It is
+ * called every time the buffer runs empty, and can for example copy the next
+ * data out of the SD-card cache using file_read().
  */
-class BufferedReadStream : public Stream {
+class BufferedReadStream : public ChunkStream {
 private:
   Stream *_baseStream;
-  unsigned char *_buffer;
-  int _bufferLen;
-  int _bufferPos;
-  void refreshBuffer();
+  ChunkStream *_chunks;
+  BufferedReadRefill _refill;
+  uint8_t *_buffer;
+  uint16_t _bufferSize;
+  uint16_t _bufferFill;
+  uint16_t _bufferPos;
+  uint16_t refreshBuffer();
+  size_t readSource(uint8_t* data, size_t length);
 public:
   /// Constructs a new buffered read stream reading from the baseStream
-  BufferedReadStream(Stream* baseStream, int BufferSize);
+  BufferedReadStream(Stream* baseStream, int bufferSize);
+  /// Constructs a new buffered read stream reading from the baseStream a chunk at a time
+  BufferedReadStream(ChunkStream* baseStream, int bufferSize);
+  /// Constructs a new buffered read stream reading using a refill function
+  BufferedReadStream(BufferedReadRefill refill, int bufferSize);
   ~BufferedReadStream();
   virtual int read();
   virtual int peek();
   virtual int available();
   virtual void flush();
+  virtual size_t acquireChunk(const uint8_t** ptr, size_t max);
+  virtual void releaseChunk(size_t count);
+  /// Reads a block of data, large blocks are read without buffering when the source allows
+  size_t readBytes(char* buffer, size_t length);
+  /// Reads a block of data, large blocks are read without buffering when the source allows
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*) buffer, length); }
+  /// Discards the data in the buffer, for when the source changed position
+  void reset(void) { _bufferFill = _bufferPos = 0; }
   size_t write(uint8_t val);
 };
 
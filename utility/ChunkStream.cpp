@@ -0,0 +1,82 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "ChunkStream.h"
+
+size_t ChunkStream::readChunks(void* data, size_t length) {
+  uint8_t* dest = (uint8_t*) data;
+  const uint8_t* chunk;
+  size_t count, total = 0;
+  while (total < length && (count = acquireChunk(&chunk, length - total))) {
+    memcpy(dest + total, chunk, count);
+    releaseChunk(count);
+    total += count;
+  }
+  return total;
+}
+
+size_t ChunkReader::read(void* data, size_t length) {
+  if (_chunks) {
+    return _chunks->readChunks(data, length);
+  } else {
+    return _stream.readBytes((char*) data, length);
+  }
+}
+
+void ChunkReader::skip(uint32_t count) {
+  const uint8_t* chunk;
+  size_t n;
+  if (_chunks) {
+    while (count && (n = _chunks->acquireChunk(&chunk, min(count, 0x7FFF)))) {
+      _chunks->releaseChunk(n);
+      count -= n;
+    }
+  } else {
+    // Read them in small blocks instead of one byte at a time
+    char buff[16];
+    while (count) {
+      n = min(count, sizeof(buff));
+      if (!_stream.readBytes(buff, n)) break;
+      count -= n;
+    }
+  }
+}
+
+size_t ChunkReader::readChunk(const uint8_t** ptr, size_t max, uint8_t* scratch, uint8_t unit) {
+  size_t count = max - (max % unit);
+  if (_chunks) {
+    size_t n = _chunks->acquireChunk(ptr, count);
+    n -= (n % unit);
+    if (n) {
+      _chunks->releaseChunk(n);
+      return n;
+    }
+
+    // The chunk ends halfway a unit, copy that one unit instead
+    count = unit;
+  }
+  *ptr = scratch;
+  return read(scratch, count);
+}
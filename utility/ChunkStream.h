@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief Contains the ChunkStream interface for reading streams without copying data
+ */
+
+#include <Arduino.h>
+
+#ifndef _CHUNK_STREAM_H_
+#define _CHUNK_STREAM_H_
+
+/**
+ * @brief Stream that gives direct access to the data it reads
+ *
+ * Instead of reading one byte at a time, a pointer to the next bytes is obtained
+ * using acquireChunk(). After processing (part of) them, releaseChunk() moves the
+ * stream past the bytes used. The data stays valid until the stream is used again.
+ * Streams reading RAM return a pointer into it, other streams return a pointer into
+ * the window or buffer they read into.
+ */
+class ChunkStream : public Stream {
+ public:
+  /// Gets a pointer to the next bytes, returns how many can be read from it (at most max), 0 at the end
+  virtual size_t acquireChunk(const uint8_t** ptr, size_t max) = 0;
+  /// Moves past bytes of the chunk last acquired
+  virtual void releaseChunk(size_t count) = 0;
+  /// Reads a block of data a chunk at a time, returns the amount of bytes read
+  size_t readChunks(void* data, size_t length);
+  /// Reads a block of data a chunk at a time, without waiting for a timeout
+  size_t readBytes(char* buffer, size_t length) { return readChunks(buffer, length); }
+  /// Reads a block of data a chunk at a time, without waiting for a timeout
+  size_t readBytes(uint8_t* buffer, size_t length) { return readChunks(buffer, length); }
+};
+
+/**
+ * @brief Reads data from any Stream, using chunks when the Stream is a ChunkStream
+ *
+ * Functions accepting a ChunkReader can be passed any Stream. Data of other streams
+ * is copied into a scratch buffer provided by the caller, so the same code handles both.
+ */
+class ChunkReader {
+ public:
+  /// Reads from a stream one byte at a time
+  ChunkReader(Stream &stream) : _stream(stream), _chunks(NULL) {}
+  /// Reads from a stream that gives direct access to its data
+  ChunkReader(ChunkStream &stream) : _stream(stream), _chunks(&stream) {}
+
+  /// Reads a single byte, -1 if none could be read
+  int read() { return _stream.read(); }
+  /// Reads a block of data, returns the amount of bytes read
+  size_t read(void* data, size_t length);
+  /// Skips over bytes of data
+  void skip(uint32_t count);
+  /**
+   * @brief Reads up to max bytes, returning a pointer to them using ptr
+   *
+   * The amount read is a multiple of unit bytes, and when the stream is not a ChunkStream,
+   * the data is copied into the scratch buffer of max bytes. Returns the amount of bytes read.
+   */
+  size_t readChunk(const uint8_t** ptr, size_t max, uint8_t* scratch, uint8_t unit = 1);
+
+ private:
+  Stream &_stream;
+  ChunkStream* _chunks;
+};
+
+#endif
@@ -27,29 +27,93 @@ THE SOFTWARE.
 
 DataBuffer::DataBuffer(const void* data, int dataSize) {
   this->data = NULL;
+  this->dataSize = 0;
+  this->_capacity = 0;
   set(data, dataSize);
 }
 
+DataBuffer::DataBuffer(const DataBuffer& other) {
+  this->data = NULL;
+  this->dataSize = 0;
+  this->_capacity = 0;
+  set(other.data, other.dataSize);
+}
+
 DataBuffer::~DataBuffer() {
-  free(data);
+  release();
+}
+
+bool DataBuffer::reserve(int newCapacity) {
+  if (newCapacity <= this->_capacity) return true;
+
+  void* newData;
+  if (!this->data && newCapacity <= DATA_BUFFER_INLINE) {
+    // Small enough to store inside the buffer itself
+    newData = this->_inline;
+    newCapacity = DATA_BUFFER_INLINE;
+  } else if (this->data == this->_inline || !this->data) {
+    // Move from the buffer itself onto the heap
+    newData = malloc(newCapacity);
+    if (!newData) return false;
+    if (this->dataSize) memcpy(newData, this->data, this->dataSize);
+  } else {
+    newData = realloc(this->data, newCapacity);
+    if (!newData) return false;
+  }
+  this->data = newData;
+  this->_capacity = newCapacity;
+  return true;
+}
+
+void DataBuffer::release() {
+  if (this->data != this->_inline) {
+    free(this->data);
+  }
+  this->data = NULL;
+  this->dataSize = 0;
+  this->_capacity = 0;
 }
 
 void DataBuffer::growToFit(int newDataSize) {
   if (this->dataSize >= newDataSize) return;
-  this->dataSize = newDataSize;
-  this->data = realloc(this->data, this->dataSize);
+  resize(newDataSize);
 }
 
 void DataBuffer::resize(int newDataSize) {
-  if (this->dataSize == newDataSize) return;
+  // Grow by half the current capacity at least, so growing one at a time does not realloc every time
+  if (newDataSize > this->_capacity) {
+    int newCapacity = this->_capacity + (this->_capacity >> 1);
+    if (newCapacity < newDataSize) newCapacity = newDataSize;
+    if (!reserve(newCapacity) && !reserve(newDataSize)) return;
+  }
   this->dataSize = newDataSize;
-  this->data = realloc(this->data, this->dataSize);
+}
+
+void DataBuffer::shrinkToFit() {
+  if (this->data == this->_inline || this->_capacity == this->dataSize) return;
+  if (!this->dataSize) {
+    release();
+  } else if (this->dataSize <= DATA_BUFFER_INLINE) {
+    memcpy(this->_inline, this->data, this->dataSize);
+    free(this->data);
+    this->data = this->_inline;
+    this->_capacity = DATA_BUFFER_INLINE;
+  } else {
+    void* newData = realloc(this->data, this->dataSize);
+    if (newData) {
+      this->data = newData;
+      this->_capacity = this->dataSize;
+    }
+  }
 }
 
 void DataBuffer::set(const void* data, int dataSize) {
-  free(this->data);
+  // Memory already allocated is re-used when large enough
+  if (dataSize > this->_capacity) {
+    release();
+    if (!reserve(dataSize)) return;
+  }
   this->dataSize = dataSize;
-  this->data = malloc(dataSize);
   memcpy(this->data, data, dataSize);
 }
 
@@ -58,6 +122,40 @@ void DataBuffer::setTextRaw(const char* text, int textLen) {
 }
 
 DataBuffer& DataBuffer::operator=( const DataBuffer& other ) {
-  set(other.data, other.dataSize);
+  if (this != &other) {
+    set(other.data, other.dataSize);
+  }
   return *this;
-}
\ No newline at end of file
+}
+
+void DataBuffer::take(DataBuffer& other) {
+  if (other.data == other._inline) {
+    // Data stored inside the other buffer can not be taken over, copy it
+    set(other.data, other.dataSize);
+    other.release();
+  } else {
+    release();
+    this->data = other.data;
+    this->dataSize = other.dataSize;
+    this->_capacity = other._capacity;
+    other.data = NULL;
+    other.dataSize = 0;
+    other._capacity = 0;
+  }
+}
+
+#if __cplusplus >= 201103L
+DataBuffer::DataBuffer(DataBuffer&& other) {
+  this->data = NULL;
+  this->dataSize = 0;
+  this->_capacity = 0;
+  take(other);
+}
+
+DataBuffer& DataBuffer::operator=( DataBuffer&& other ) {
+  if (this != &other) {
+    take(other);
+  }
+  return *this;
+}
+#endif
\ No newline at end of file
@@ -34,29 +34,49 @@ THE SOFTWARE.
 #ifndef _DATA_BUFFER_H_
 #define _DATA_BUFFER_H_
 
+/// Amount of bytes stored inside the DataBuffer itself, larger data is stored on the heap
+#define DATA_BUFFER_INLINE  8
+
 /**
  * @brief Maintains data stored on the heap and frees it when the class is destructed
  *
  * The problem of storing arrays as containers is that they are fixed-size, and with heap
  * memory the size and freeing all has to be maintained. That is what this class solves.
  * Memory can be easily allocated/resized and destroyed as the class is used.
+ *
+ * Small data, such as short palettes and texts, is stored inside the buffer itself
+ * without using the heap. When growing, the heap memory grows by half its size at a
+ * time, and shrinking keeps the memory for later use, so the heap does not fragment
+ * as quickly. Use shrinkToFit() to release memory that is no longer needed.
  */
 class DataBuffer : public PHN_TextContainer {
 public:
   /// Creates a new buffer without any data
-  DataBuffer() : data(NULL), dataSize(0) {}
+  DataBuffer() : data(NULL), dataSize(0), _capacity(0) {}
   /// Creates a new buffer, copying the initial data into the buffer
   DataBuffer(const void* data, int dataSize);
+  /// Creates a new buffer, copying the data of another buffer
+  DataBuffer(const DataBuffer& other);
   /// Destructor frees the memory
   ~DataBuffer();
   /// Resizes the buffer preserving contents to newDataSize, shrinking if needed
   void resize(int newDataSize);
   /// Resizes the buffer preserving contents to fit newDataSize
   void growToFit(int newDataSize);
+  /// Releases memory not needed to store the current data
+  void shrinkToFit();
+  /// Gets the amount of bytes that can be stored without allocating more memory
+  int capacity() const { return _capacity; }
   /// Sets new data to be stored, the data is copied into this buffer
   void set(const void* data, int dataSize);
   /// Assigns data from one buffer to another
   DataBuffer& operator=( const DataBuffer& other );
+#if __cplusplus >= 201103L
+  /// Creates a new buffer, taking over the memory of a temporary buffer
+  DataBuffer(DataBuffer&& other);
+  /// Takes over the memory of a temporary buffer instead of copying the data
+  DataBuffer& operator=( DataBuffer&& other );
+#endif
 
   // Implementation for PHN_TextContainer
   virtual const char* text() { return (char*) data; }
@@ -64,6 +84,17 @@ public:
   
   void* data;
   int dataSize;
+
+private:
+  /// Makes sure newCapacity bytes can be stored, preserving contents. Returns false if out of memory
+  bool reserve(int newCapacity);
+  /// Frees the memory, leaving an empty buffer
+  void release();
+  /// Takes over the memory of another buffer, leaving the other buffer empty
+  void take(DataBuffer& other);
+
+  int _capacity;
+  uint8_t _inline[DATA_BUFFER_INLINE];
 };
 
 #endif
\ No newline at end of file
@@ -26,18 +26,24 @@ THE SOFTWARE.
 #include "FlashMemoryStream.h"
 
 FlashMemoryStream::FlashMemoryStream(const void *startAddress, uint32_t length) {
-  _startAddress = (const uint8_t*) startAddress;
+  _address = (uintptr_t) startAddress;
   _length = length;
   _pos = 0;
 }
 
+FlashMemoryStream FlashMemoryStream::far(uint_farptr_t address, uint32_t length) {
+  FlashMemoryStream stream(NULL, length);
+  stream._address = address;
+  return stream;
+}
+
 int FlashMemoryStream::peek() {
-  return pgm_read_byte_far(_startAddress + _pos);
+  return pgm_read_byte_far(_address + _pos);
 }
 
 int FlashMemoryStream::read() {
-  if (available()) {
-    return pgm_read_byte_far(_startAddress + _pos++);
+  if (_pos < _length) {
+    return pgm_read_byte_far(_address + _pos++);
   } else {
     return -1;
   }
@@ -51,8 +57,30 @@ void FlashMemoryStream::flush() {
   // Nothing is done here
 }
 
-void FlashMemoryStream::seek(uint16_t position) {
-  _pos = position;
+size_t FlashMemoryStream::acquireChunk(const uint8_t** ptr, size_t max) {
+  // Flash memory can not be pointed at directly, copy the chunk into the window
+  uint32_t count = min(_length - _pos, (uint32_t) min(max, FLASH_STREAM_WINDOW));
+  memcpy_PF(_window, _address + _pos, count);
+  *ptr = _window;
+  return count;
+}
+
+void FlashMemoryStream::releaseChunk(size_t count) {
+  _pos += count;
+}
+
+size_t FlashMemoryStream::readBytes(char* buffer, size_t length) {
+  if (length > (_length - _pos)) {
+    length = _length - _pos;
+  }
+  memcpy_PF(buffer, _address + _pos, length);
+  _pos += length;
+  return length;
+}
+
+void FlashMemoryStream::seek(uint32_t position) {
+  // Never past the end, so the remaining length can not wrap around
+  _pos = min(position, _length);
 }
 
 void FlashMemoryStream::reset() {
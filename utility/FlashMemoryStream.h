@@ -30,34 +30,90 @@ THE SOFTWARE.
 
 #include <Arduino.h>
 #include <avr/pgmspace.h>
+#include "ChunkStream.h"
 
 #ifndef _FLASH_MEM_STREAM_H_
 #define _FLASH_MEM_STREAM_H_
 
+/// Amount of bytes copied from flash memory into RAM for every chunk acquired
+#define FLASH_STREAM_WINDOW  32
+
 /**
  * @brief Reads flash memory as a data stream
  *
  * Is used to allow RAM, SD and FLASH memory to be accessed as a Stream
+ * Data stored beyond the first 64 KB of flash can be read by creating the
+ * stream using far(), passing the address obtained using pgm_get_far_address().
  */
-class FlashMemoryStream : public Stream {
+class FlashMemoryStream : public ChunkStream {
  private:
-  const uint8_t *_startAddress;
+  uint_farptr_t _address;
   uint32_t _pos;
   uint32_t _length;
+  uint8_t _window[FLASH_STREAM_WINDOW];
  public:
   /// Creates a new Flash Memory stream reading from at the address specified
   FlashMemoryStream(const void *startAddress, uint32_t length = 0xFFFFFFFF);
+  /// Creates a new Flash Memory stream reading from the far address specified
+  static FlashMemoryStream far(uint_farptr_t address, uint32_t length = 0xFFFFFFFF);
 
   virtual int read();
   virtual int peek();
   virtual int available();
   virtual void flush();
-  /// Seeks the stream to a certain position in memory
-  void seek(uint16_t position);
+  virtual size_t acquireChunk(const uint8_t** ptr, size_t max);
+  virtual void releaseChunk(size_t count);
+  /// Reads a block of data, copying it from flash memory in one go
+  size_t readBytes(char* buffer, size_t length);
+  /// Reads a block of data, copying it from flash memory in one go
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*) buffer, length); }
+  /// Seeks the stream to a certain position in memory, positions past the end seek to the end
+  void seek(uint32_t position);
+  /// Gets the current position in memory
+  uint32_t position(void) { return _pos; }
+  /// Gets the total length of the memory read, available() is limited to 32767
+  uint32_t length(void) { return _length; }
   /// Resets the stream to the beginning
   void reset(void);
   /// Writing to flash memory is not supported - does nothing
   size_t write(uint8_t val);
 };
 
+/**
+ * @brief Indexes many assets, such as images, packed together in flash memory
+ *
+ * The packed data starts with the amount of assets as a 16-bit value, followed by
+ * the 32-bit offset of every asset and the offset of the end of the last asset.
+ * Offsets are relative to the start of the packed data, all values are little-endian.
+ * The asset data follows after this table.
+ *
+ * @code
+ * FlashAssetTable icons = FlashAssetTable::far(pgm_get_far_address(icons_data));
+ * FlashMemoryStream stream = icons.open(3);
+ * display.drawImage(stream, 10, 10);
+ * @endcode
+ */
+class FlashAssetTable {
+ public:
+  /// Reads the table of packed data at the address specified
+  FlashAssetTable(const void *startAddress) : _address((uintptr_t) startAddress) {}
+  /// Reads the table of packed data at the far address specified
+  static FlashAssetTable far(uint_farptr_t address) {
+    FlashAssetTable table(NULL);
+    table._address = address;
+    return table;
+  }
+  /// Gets the amount of assets stored
+  uint16_t count(void) { return pgm_read_word_far(_address); }
+  /// Gets the far address of an asset, which can be used with the FLASH_Image macro
+  uint_farptr_t address(uint16_t index) { return _address + offset(index); }
+  /// Gets the size of an asset in bytes
+  uint32_t size(uint16_t index) { return offset(index + 1) - offset(index); }
+  /// Opens a stream reading an asset
+  FlashMemoryStream open(uint16_t index) { return FlashMemoryStream::far(address(index), size(index)); }
+ private:
+  uint32_t offset(uint16_t index) { return pgm_read_dword_far(_address + 2 + ((uint32_t) index << 2)); }
+  uint_farptr_t _address;
+};
+
 #endif
\ No newline at end of file
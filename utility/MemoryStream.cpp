@@ -57,6 +57,16 @@ void MemoryStream::flush() {
   // Nothing is done here
 }
 
+size_t MemoryStream::acquireChunk(const uint8_t** ptr, size_t max) {
+  // The data is read straight from RAM
+  *ptr = _data + _pos;
+  return min((size_t) (_length - _pos), max);
+}
+
+void MemoryStream::releaseChunk(size_t count) {
+  _pos += count;
+}
+
 void MemoryStream::seek(uint16_t position) {
   _pos = position;
 }
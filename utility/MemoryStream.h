@@ -29,6 +29,7 @@ THE SOFTWARE.
  */
 
 #include <Arduino.h>
+#include "ChunkStream.h"
 
 #ifndef _MEMORY_STREAM_H_
 #define _MEMORY_STREAM_H_
@@ -36,7 +37,7 @@ THE SOFTWARE.
 /**
  * @brief Stream class implementation for reading RAM memory
  */
-class MemoryStream : public Stream {
+class MemoryStream : public ChunkStream {
  private:
   const uint8_t* _data;
   uint16_t _length;
@@ -50,6 +51,8 @@ class MemoryStream : public Stream {
   virtual int peek();
   virtual int available();
   virtual void flush();
+  virtual size_t acquireChunk(const uint8_t** ptr, size_t max);
+  virtual void releaseChunk(size_t count);
   void seek(uint16_t position);
   /// Resets the stream to the beginning
   void reset(void);
@@ -78,9 +78,11 @@ int strcpy_count(char* destination, const char* source);
 void shiftElements(void* ptr, int blockSize, int blockCount, int shiftCount);
 
 /* Utility classes are included here as they may use PHNUtils.h */
+#include "ChunkStream.h"
 #include "BufferedReadStream.h"
 #include "FlashMemoryStream.h"
 #include "MemoryStream.h"
+#include "SRAMStream.h"
 #include "DataBuffer.h"
 
 #endif
@@ -0,0 +1,137 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "SRAMStream.h"
+
+SRAMStream::SRAMStream(uint16_t address, uint16_t length) {
+  _address = address;
+  _length = length;
+  _pos = 0;
+  _bufferPos = 0;
+  _bufferLength = 0;
+  _dirty = 0;
+}
+
+SRAMStream::~SRAMStream() {
+  flush();
+}
+
+int SRAMStream::peek() {
+  if (_pos >= _length) {
+    return -1;
+  }
+
+  // Read ahead the next window when the position is outside the current one
+  // Bytes written to the window are read back from it, they are stored once it is replaced
+  if (_pos < _bufferPos || (_pos - _bufferPos) >= _bufferLength) {
+    flush();
+    _bufferPos = _pos;
+    _bufferLength = min(_length - _pos, SRAM_STREAM_WINDOW);
+    sram.readBlock(_address + _pos, _buffer, _bufferLength);
+  }
+  return (uint8_t) _buffer[_pos - _bufferPos];
+}
+
+int SRAMStream::read() {
+  int value = peek();
+  if (value != -1) {
+    _pos++;
+  }
+  return value;
+}
+
+int SRAMStream::available() {
+  return min(_length - _pos, 0x7fff);
+}
+
+void SRAMStream::flush() {
+  // The data written stays in the window, it can be read back from there
+  if (_dirty) {
+    sram.writeBlock(_address + _bufferPos, _buffer, _bufferLength);
+    _dirty = 0;
+  }
+}
+
+size_t SRAMStream::write(uint8_t val) {
+  if (_pos >= _length) {
+    return 0;
+  }
+
+  // Start a new window unless continuing to write the current one
+  if (!_dirty || _pos != (_bufferPos + _bufferLength) || _bufferLength == SRAM_STREAM_WINDOW) {
+    flush();
+    _dirty = 1;
+    _bufferPos = _pos;
+    _bufferLength = 0;
+  }
+  _buffer[_bufferLength++] = val;
+  _pos++;
+  return 1;
+}
+
+size_t SRAMStream::write(const uint8_t *buffer, size_t size) {
+  uint16_t start, end;
+
+  // Large blocks are written in a single transfer, without using the window
+  if (size < SRAM_STREAM_WINDOW) {
+    return Stream::write(buffer, size);
+  }
+  if (size > (size_t) (_length - _pos)) {
+    size = _length - _pos;
+  }
+  flush();
+  sram.writeBlock(_address + _pos, (const char*) buffer, size);
+
+  // Update the part of the window that was written over, so it can still be read from
+  start = max(_pos, _bufferPos);
+  end = min(_pos + size, _bufferPos + _bufferLength);
+  if (start < end) {
+    memcpy(_buffer + (start - _bufferPos), buffer + (start - _pos), end - start);
+  }
+  _pos += size;
+  return size;
+}
+
+size_t SRAMStream::acquireChunk(const uint8_t** ptr, size_t max) {
+  // Chunks are served from the read-ahead window
+  if (peek() == -1) {
+    return 0;
+  }
+  uint8_t offset = _pos - _bufferPos;
+  *ptr = (const uint8_t*) _buffer + offset;
+  return min((size_t) (_bufferLength - offset), max);
+}
+
+void SRAMStream::releaseChunk(size_t count) {
+  _pos += count;
+}
+
+void SRAMStream::seek(uint16_t position) {
+  _pos = min(position, _length);
+}
+
+void SRAMStream::reset() {
+  seek(0);
+}
@@ -0,0 +1,82 @@
+/*
+The MIT License (MIT)
+
+This file is part of the Phoenard Arduino library
+Copyright (c) 2014 Phoenard
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief Contains the SRAMStream for accessing the external SRAM as a Stream
+ */
+
+#include <Arduino.h>
+#include <PHNSRAM.h>
+#include "ChunkStream.h"
+
+#ifndef _SRAM_STREAM_H_
+#define _SRAM_STREAM_H_
+
+/// Amount of bytes read from or written to the SRAM chip in a single transfer
+#define SRAM_STREAM_WINDOW  32
+
+/**
+ * @brief Stream class implementation for reading and writing the external SRAM
+ *
+ * Data is read ahead a window of bytes at a time, and written once a window is
+ * filled, so the chip is accessed using a single sequential transfer per window.
+ * Call flush() after writing to make sure all data is stored in the SRAM, and
+ * do not write the same SRAM area by other means while reading from the stream.
+ * For example, an image can be staged from the SD card into SRAM once, after
+ * which it can be drawn repeatedly using seek(0) and PHN_Display::drawImage().
+ */
+class SRAMStream : public ChunkStream {
+ private:
+  uint16_t _address;
+  uint16_t _length;
+  uint16_t _pos;
+  uint16_t _bufferPos;
+  uint8_t _bufferLength;
+  uint8_t _dirty;
+  char _buffer[SRAM_STREAM_WINDOW];
+ public:
+  /// Creates a new SRAMStream starting at the SRAM address specified
+  SRAMStream(uint16_t address, uint16_t length = SRAM_CAPACITY);
+  /// Writes out any data not yet written
+  ~SRAMStream();
+  virtual int read();
+  virtual int peek();
+  virtual int available();
+  virtual void flush();
+  virtual size_t write(uint8_t val);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+  virtual size_t acquireChunk(const uint8_t** ptr, size_t max);
+  virtual void releaseChunk(size_t count);
+  /// Seeks the stream to a certain position in the SRAM area, positions past the end seek to the end
+  void seek(uint16_t position);
+  /// Gets the current position in the SRAM area
+  uint16_t position(void) { return _pos; }
+  /// Resets the stream to the beginning
+  void reset(void);
+};
+
+#endif